@@ -0,0 +1,139 @@
+#include "WorkbookGenerator.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+#include <zip.h>
+
+#include "ColumnarSheet.hpp"
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+std::string WorkbookGenerator::generate(const std::string &directory, const workbook_shape_t &shape)
+{
+	std::string name = "Synthetic_" + std::to_string(shape.rows) + "x" + std::to_string(shape.columns) + "x" +
+					   std::to_string(shape.sheets) + "_" + std::to_string(shape.distinct_percent) + ".xlsx";
+	std::filesystem::create_directories(directory);
+	std::string path = (std::filesystem::path(directory) / name).string();
+	if (std::filesystem::exists(path))
+	{
+		return path;
+	}
+
+	// The contents of each part must stay alive until the archive is closed and written.
+	std::list<std::pair<std::string, std::string>> parts;
+	parts.emplace_back("[Content_Types].xml",
+					   "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+					   "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+					   "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+					   "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+					   "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+					   "</Types>");
+	parts.emplace_back("_rels/.rels",
+					   "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+					   "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+					   "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+					   "</Relationships>");
+
+	std::string workbook = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+						   "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" "
+						   "xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\"><sheets>";
+	std::string relationships = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+								"<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+	for (size_t i = 1; i <= shape.sheets; ++i)
+	{
+		std::string index = std::to_string(i);
+		workbook += "<sheet name=\"Sheet" + index + "\" sheetId=\"" + index + "\" r:id=\"rId" + index + "\"/>";
+		relationships += "<Relationship Id=\"rId" + index + "\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet" + index + ".xml\"/>";
+		parts.emplace_back("xl/worksheets/sheet" + index + ".xml", sheetXml(shape, i - 1));
+	}
+	parts.emplace_back("xl/workbook.xml", workbook + "</sheets></workbook>");
+	parts.emplace_back("xl/_rels/workbook.xml.rels", relationships + "</Relationships>");
+	parts.emplace_back("xl/sharedStrings.xml", sharedStringsXml(stringCount(shape)));
+
+	// Write to a temporary name so an interrupted run never leaves a partial workbook behind.
+	std::string temporary_path = path + ".tmp";
+	int err = 0;
+	zip *book = zip_open(temporary_path.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &err);
+	if (book == nullptr)
+	{
+		throw std::runtime_error("[Excel Parser] (ERROR) Error creating synthetic workbook " + temporary_path + ": " + std::to_string(err));
+	}
+	for (auto &part : parts)
+	{
+		zip_source_t *source = zip_source_buffer(book, part.second.data(), part.second.size(), 0);
+		if (source == nullptr || zip_file_add(book, part.first.c_str(), source, ZIP_FL_OVERWRITE) < 0)
+		{
+			zip_source_free(source);
+			zip_discard(book);
+			throw std::runtime_error("[Excel Parser] (ERROR) Error adding " + part.first + " to synthetic workbook " + temporary_path);
+		}
+	}
+	if (zip_close(book) != 0)
+	{
+		zip_discard(book);
+		throw std::runtime_error("[Excel Parser] (ERROR) Error writing synthetic workbook " + temporary_path);
+	}
+	std::filesystem::rename(temporary_path, path);
+	return path;
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+std::string WorkbookGenerator::sheetXml(const workbook_shape_t &shape, size_t sheet)
+{
+	size_t strings = stringCount(shape);
+	std::vector<std::string> column_names;
+	for (size_t c = 0; c < shape.columns; ++c)
+	{
+		column_names.push_back(columnName(static_cast<int>(c)));
+	}
+
+	std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+					  "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>";
+	size_t string_cell = sheet * shape.rows * (shape.columns / 2);
+	for (size_t r = 1; r <= shape.rows; ++r)
+	{
+		std::string row_name = std::to_string(r);
+		xml += "<row r=\"" + row_name + "\">";
+		for (size_t c = 0; c < shape.columns; ++c)
+		{
+			// Even columns hold numbers and odd columns hold shared strings, cycling through the distinct strings.
+			if (c % 2 == 0)
+			{
+				xml += "<c r=\"" + column_names[c] + row_name + "\"><v>" + std::to_string(r * 0.5 + c) + "</v></c>";
+			}
+			else
+			{
+				xml += "<c r=\"" + column_names[c] + row_name + "\" t=\"s\"><v>" + std::to_string(string_cell++ % strings) + "</v></c>";
+			}
+		}
+		xml += "</row>";
+	}
+	return xml + "</sheetData></worksheet>";
+}
+
+std::string WorkbookGenerator::sharedStringsXml(size_t count)
+{
+	std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+					  "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" uniqueCount=\"" +
+					  std::to_string(count) + "\">";
+	for (size_t i = 0; i < count; ++i)
+	{
+		xml += "<si><t>String value " + std::to_string(i) + "</t></si>";
+	}
+	return xml + "</sst>";
+}
+
+size_t WorkbookGenerator::stringCount(const workbook_shape_t &shape)
+{
+	size_t string_cells = shape.rows * (shape.columns / 2) * shape.sheets;
+	return std::max<size_t>(1, string_cells * shape.distinct_percent / 100);
+}
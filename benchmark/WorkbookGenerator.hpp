@@ -0,0 +1,80 @@
+/**
+ * @file    WorkbookGenerator.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the WorkbookGenerator, which writes synthetic Excel files for the
+ *          benchmarks.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef WorkbookGenerator_HPP
+#define WorkbookGenerator_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace excel_parser
+{
+    /**
+     * @brief Structural representation of the shape of a synthetic workbook.
+     */
+    struct workbook_shape_t
+    {
+        /// Number of rows in each sheet.
+        size_t rows = 1000;
+        /// Number of columns in each sheet, alternating between numbers and shared strings.
+        size_t columns = 10;
+        /// Number of sheets in the workbook.
+        size_t sheets = 1;
+        /// Percentage of the string cells holding a distinct shared string, the rest repeat earlier strings.
+        size_t distinct_percent = 10;
+    };
+
+    /**
+     * @brief   Class WorkbookGenerator writes synthetic Excel files of a given shape.
+     */
+    class WorkbookGenerator
+    {
+    public:
+        /**
+         * @brief           Method generate writes a synthetic Excel file, unless a file for the shape already exists.
+         * @param directory string path of the directory the file is written in.
+         * @param shape     shape of the workbook.
+         * @return          std::string path of the file.
+         * @throws          std::runtime_error if the file cannot be written.
+         */
+        static std::string generate(const std::string &directory, const workbook_shape_t &shape);
+
+        /**
+         * @brief           Method cellCount computes the number of cells in a workbook of a given shape.
+         * @param shape     shape of the workbook.
+         * @return          size_t number of cells across all the sheets.
+         */
+        static size_t cellCount(const workbook_shape_t &shape) { return shape.rows * shape.columns * shape.sheets; }
+
+    private:
+        /**
+         * @brief           Method sheetXml builds the XML of one sheet.
+         * @param shape     shape of the workbook.
+         * @param sheet     index of the sheet.
+         * @return          std::string XML of the sheet.
+         */
+        static std::string sheetXml(const workbook_shape_t &shape, size_t sheet);
+
+        /**
+         * @brief           Method sharedStringsXml builds the XML of the shared strings.
+         * @param count     number of distinct shared strings.
+         * @return          std::string XML of the shared strings.
+         */
+        static std::string sharedStringsXml(size_t count);
+
+        /**
+         * @brief           Method stringCount computes the number of distinct shared strings in a workbook.
+         * @param shape     shape of the workbook.
+         * @return          size_t number of distinct shared strings, at least 1.
+         */
+        static size_t stringCount(const workbook_shape_t &shape);
+    };
+}
+
+#endif /* WorkbookGenerator_HPP */
@@ -0,0 +1,485 @@
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "ExcelParser.hpp"
+#include "WorkbookGenerator.hpp"
+
+using namespace std;
+using namespace excel_parser;
+
+/// Number of calls to the global operator new since the benchmarks started.
+static atomic<uint64_t> allocation_count(0);
+
+void *operator new(size_t size)
+{
+	++allocation_count;
+	void *p = malloc(size == 0 ? 1 : size);
+	if (p == nullptr)
+	{
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+/**
+ * @brief   Function shapeOf builds the shape of a workbook from the arguments of a benchmark.
+ * @param   state benchmark state whose arguments are rows, columns, sheets, and the percentage of distinct strings.
+ * @return  workbook_shape_t shape of the workbook.
+ */
+workbook_shape_t shapeOf(const benchmark::State &state)
+{
+	workbook_shape_t shape;
+	shape.rows = static_cast<size_t>(state.range(0));
+	shape.columns = static_cast<size_t>(state.range(1));
+	shape.sheets = static_cast<size_t>(state.range(2));
+	shape.distinct_percent = static_cast<size_t>(state.range(3));
+	return shape;
+}
+
+/**
+ * @brief   Function workbookFor generates (or reuses) the synthetic workbook for a benchmark.
+ * @param   state benchmark state holding the shape of the workbook.
+ * @return  string path of the workbook.
+ */
+string workbookFor(const benchmark::State &state)
+{
+	return WorkbookGenerator::generate((filesystem::temp_directory_path() / "ExcelParserBenchmark").string(), shapeOf(state));
+}
+
+/**
+ * @brief   Function reportThroughput sets the throughput counters of a benchmark.
+ * @param   state       benchmark state.
+ * @param   file_name   path of the workbook read by each iteration.
+ * @param   cells       number of cells read by each iteration.
+ */
+void reportThroughput(benchmark::State &state, const string &file_name, size_t cells)
+{
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * filesystem::file_size(file_name)));
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * cells));
+	state.counters["cells"] = static_cast<double>(cells);
+#ifndef _WIN32
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	state.counters["peak_rss_mb"] = usage.ru_maxrss / 1024.0;
+#endif
+}
+
+/**
+ * @brief   Function workbookShapes registers the range of workbook shapes used by the benchmarks that read files.
+ * @param   b benchmark to register the shapes with.
+ */
+void workbookShapes(benchmark::internal::Benchmark *b)
+{
+	b->ArgNames({"rows", "cols", "sheets", "distinct%"});
+	// Sizes from 1K to 10M cells in one tall sheet with few distinct strings.
+	b->Args({100, 10, 1, 10});
+	b->Args({10000, 10, 1, 10});
+	b->Args({100000, 10, 1, 10});
+	b->Args({1000000, 10, 1, 10});
+	// Wide rather than tall.
+	b->Args({1000, 1000, 1, 10});
+	// Every string distinct.
+	b->Args({100000, 10, 1, 100});
+	// Many small sheets.
+	b->Args({1000, 10, 100, 10});
+	b->Unit(benchmark::kMillisecond);
+}
+
+void BM_openExcelFile(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	for (auto _ : state)
+	{
+		parser->openExcelFile(file_name);
+		state.PauseTiming();
+		parser->closeExcelFile(file_name);
+		state.ResumeTiming();
+	}
+	reportThroughput(state, file_name, WorkbookGenerator::cellCount(shapeOf(state)));
+}
+BENCHMARK(BM_openExcelFile)->Apply(workbookShapes);
+
+void BM_openExcelFileParallel(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	open_options_t options;
+	options.threads = 0;
+	for (auto _ : state)
+	{
+		parser->openExcelFile(file_name, options);
+		state.PauseTiming();
+		parser->closeExcelFile(file_name);
+		state.ResumeTiming();
+	}
+	reportThroughput(state, file_name, WorkbookGenerator::cellCount(shapeOf(state)));
+}
+BENCHMARK(BM_openExcelFileParallel)->Args({1000, 10, 100, 10})->Args({100000, 10, 8, 10})->Unit(benchmark::kMillisecond);
+
+void BM_closeExcelFile(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		parser->openExcelFile(file_name);
+		state.ResumeTiming();
+		parser->closeExcelFile(file_name);
+	}
+	reportThroughput(state, file_name, WorkbookGenerator::cellCount(shapeOf(state)));
+}
+BENCHMARK(BM_closeExcelFile)->Args({100000, 10, 1, 10})->Args({1000000, 10, 1, 10})->Iterations(5)->Unit(benchmark::kMillisecond);
+
+void BM_openExcelFileReadAhead(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	open_options_t options;
+	options.read_ahead = true;
+	for (auto _ : state)
+	{
+		parser->openExcelFile(file_name, options);
+		state.PauseTiming();
+		parser->closeExcelFile(file_name);
+		state.ResumeTiming();
+	}
+	reportThroughput(state, file_name, WorkbookGenerator::cellCount(shapeOf(state)));
+}
+BENCHMARK(BM_openExcelFileReadAhead)->Args({100000, 10, 1, 10})->Args({1000000, 10, 1, 10})->Unit(benchmark::kMillisecond);
+
+void BM_getSheet(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(parser->getSheet(file_name, "Sheet1"));
+	}
+	parser->closeExcelFile(file_name);
+	reportThroughput(state, file_name, shapeOf(state).rows * shapeOf(state).columns);
+}
+BENCHMARK(BM_getSheet)->Args({10000, 10, 1, 10})->Args({100000, 10, 1, 10})->Unit(benchmark::kMillisecond);
+
+void BM_getSheetHandle(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(parser->getSheetHandle(file_name, "Sheet1"));
+	}
+	parser->closeExcelFile(file_name);
+}
+BENCHMARK(BM_getSheetHandle)->Args({10000, 10, 1, 10});
+
+void BM_getSharedString(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	size_t strings = parser->getSharedStringTable(file_name)->size();
+	mt19937 generator(42);
+	uniform_int_distribution<int> distribution(0, static_cast<int>(strings) - 1);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(parser->getSharedString(file_name, distribution(generator)));
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_getSharedString)->Args({10000, 10, 1, 10})->Args({10000, 10, 1, 100});
+
+void BM_getSharedStringView(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	size_t strings = parser->getSharedStringTable(file_name)->size();
+	mt19937 generator(42);
+	uniform_int_distribution<int> distribution(0, static_cast<int>(strings) - 1);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(parser->getSharedStringView(file_name, distribution(generator)));
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_getSharedStringView)->Args({10000, 10, 1, 10})->Args({10000, 10, 1, 100});
+
+void BM_readTextCells(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	open_options_t options;
+	options.resolve_strings = state.range(4) != 0;
+	parser->openExcelFile(file_name, options);
+	sheet_handle s = parser->getSheetHandle(file_name, "Sheet1");
+	for (auto _ : state)
+	{
+		size_t characters = 0;
+		for (auto &r : *s)
+		{
+			for (auto &c : r.second)
+			{
+				if (c.second.type == STRING)
+				{
+					characters += options.resolve_strings ? c.second.getText().size() : parser->getSharedStringView(file_name, c.second.getStringIndex()).size();
+				}
+			}
+		}
+		benchmark::DoNotOptimize(characters);
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * shapeOf(state).rows * shapeOf(state).columns / 2));
+}
+BENCHMARK(BM_readTextCells)->ArgNames({"rows", "cols", "sheets", "distinct%", "resolved"})->Args({100000, 10, 1, 10, 0})->Args({100000, 10, 1, 10, 1})->Unit(benchmark::kMillisecond);
+
+void BM_streamSheet(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	for (auto _ : state)
+	{
+		size_t cells = 0;
+		parser->streamSheet(file_name, "Sheet1", [&cells](int row_id, const row &r)
+							{ cells += r.size(); });
+		benchmark::DoNotOptimize(cells);
+	}
+	reportThroughput(state, file_name, shapeOf(state).rows * shapeOf(state).columns);
+}
+BENCHMARK(BM_streamSheet)->Args({10000, 10, 1, 10})->Args({1000000, 10, 1, 10})->Iterations(5)->Unit(benchmark::kMillisecond);
+
+void BM_openSheetReader(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	for (auto _ : state)
+	{
+		unique_ptr<SheetReader> cursor = parser->openSheetReader(file_name, "Sheet1");
+		size_t cells = 0;
+		while (cursor->next())
+		{
+			cells += cursor->getRow().size();
+		}
+		benchmark::DoNotOptimize(cells);
+	}
+	reportThroughput(state, file_name, shapeOf(state).rows * shapeOf(state).columns);
+}
+BENCHMARK(BM_openSheetReader)->Args({10000, 10, 1, 10})->Args({1000000, 10, 1, 10})->Iterations(5)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief   Structural representation of the first four columns of a generated sheet, which alternate between numbers
+ *          and strings.
+ */
+struct generated_row_t
+{
+	double a = 0;
+	string b;
+	double c = 0;
+	string d;
+};
+
+void BM_readRecordsGeneric(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	for (auto _ : state)
+	{
+		parser->openExcelFile(file_name);
+		vector<generated_row_t> records;
+		for (auto &r : parser->getSheet(file_name, "Sheet1"))
+		{
+			generated_row_t record;
+			record.a = r.second.at("A").getNumber();
+			record.b = parser->getSharedString(file_name, r.second.at("B").getStringIndex());
+			record.c = r.second.at("C").getNumber();
+			record.d = parser->getSharedString(file_name, r.second.at("D").getStringIndex());
+			records.push_back(std::move(record));
+		}
+		parser->closeExcelFile(file_name);
+		benchmark::DoNotOptimize(records);
+	}
+	reportThroughput(state, file_name, shapeOf(state).rows);
+}
+BENCHMARK(BM_readRecordsGeneric)->Args({100000, 10, 1, 10})->Iterations(5)->Unit(benchmark::kMillisecond);
+
+void BM_readSheetAs(benchmark::State &state)
+{
+	using generated_schema = schema_t<generated_row_t,
+									  field_t<columnOf("A"), &generated_row_t::a>,
+									  field_t<columnOf("B"), &generated_row_t::b>,
+									  field_t<columnOf("C"), &generated_row_t::c>,
+									  field_t<columnOf("D"), &generated_row_t::d>>;
+	string file_name = workbookFor(state);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(ExcelParser::readSheetAs<generated_schema>(file_name, "Sheet1"));
+	}
+	reportThroughput(state, file_name, shapeOf(state).rows);
+}
+BENCHMARK(BM_readSheetAs)->Args({100000, 10, 1, 10})->Iterations(5)->Unit(benchmark::kMillisecond);
+
+void BM_columnarSum(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	shared_ptr<const ColumnarSheet> columnar = parser->getColumnarSheetHandle(file_name, "Sheet1");
+	const ColumnarSheet::Column &column = columnar->getColumn("A");
+	for (auto _ : state)
+	{
+		double total = 0;
+		for (size_t i = 0; i < column.size(); ++i)
+		{
+			total += column.isNumber(i) ? column.getNumbers()[i] : 0;
+		}
+		benchmark::DoNotOptimize(total);
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * column.size()));
+}
+BENCHMARK(BM_columnarSum)->Args({100000, 10, 1, 10});
+
+void BM_aggregateColumn(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	shared_ptr<const ColumnarSheet> columnar = parser->getColumnarSheetHandle(file_name, "Sheet1");
+	const ColumnarSheet::Column &column = columnar->getColumn("A");
+	unsigned int threads = static_cast<unsigned int>(state.range(4));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(column.aggregate(threads));
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * column.size()));
+}
+BENCHMARK(BM_aggregateColumn)->ArgNames({"rows", "cols", "sheets", "distinct%", "threads"})->Args({100000, 10, 1, 10, 1})->Args({1000000, 10, 1, 10, 1})->Args({1000000, 10, 1, 10, 4})->UseRealTime();
+
+void BM_buildColumnarSheet(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	sheet_handle s = parser->getSheetHandle(file_name, "Sheet1");
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(ColumnarSheet::fromSheet(*s));
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * shapeOf(state).rows * shapeOf(state).columns));
+}
+BENCHMARK(BM_buildColumnarSheet)->Args({100000, 10, 1, 10})->Unit(benchmark::kMillisecond);
+
+void BM_exportSheetToArrow(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	parser->getColumnarSheetHandle(file_name, "Sheet1");
+	for (auto _ : state)
+	{
+		ArrowArray array;
+		ArrowSchema schema;
+		parser->exportSheetToArrow(file_name, "Sheet1", &array, &schema);
+		array.release(&array);
+		schema.release(&schema);
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * shapeOf(state).rows * shapeOf(state).columns));
+}
+BENCHMARK(BM_exportSheetToArrow)->Args({100000, 10, 1, 10})->Unit(benchmark::kMicrosecond);
+
+void BM_scanColumnLookup(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	sheet_handle s = parser->getSheetHandle(file_name, "Sheet1");
+	size_t strings = parser->getSharedStringTable(file_name)->size();
+	mt19937 generator(42);
+	uniform_int_distribution<int> distribution(0, static_cast<int>(strings) - 1);
+	for (auto _ : state)
+	{
+		string value = parser->getSharedString(file_name, distribution(generator));
+		vector<int> rows;
+		for (auto &r : *s)
+		{
+			const cell_t *c = r.second.find("B");
+			if (c != nullptr && c->type == STRING && parser->getSharedStringView(file_name, c->getStringIndex()) == value)
+			{
+				rows.push_back(r.first);
+			}
+		}
+		benchmark::DoNotOptimize(rows);
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_scanColumnLookup)->Args({100000, 10, 1, 10})->Unit(benchmark::kMillisecond);
+
+void BM_columnIndexLookup(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	parser->openExcelFile(file_name);
+	shared_ptr<const ColumnIndex> index = parser->getColumnIndex(file_name, "Sheet1", "B");
+	size_t strings = parser->getSharedStringTable(file_name)->size();
+	mt19937 generator(42);
+	uniform_int_distribution<int> distribution(0, static_cast<int>(strings) - 1);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(index->findEqual(parser->getSharedStringView(file_name, distribution(generator))));
+	}
+	parser->closeExcelFile(file_name);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_columnIndexLookup)->Args({100000, 10, 1, 10});
+
+void BM_allocationsPerCell(benchmark::State &state)
+{
+	string file_name = workbookFor(state);
+	ExcelParser *parser = ExcelParser::getInstance();
+	uint64_t allocations = 0;
+	for (auto _ : state)
+	{
+		uint64_t before = allocation_count;
+		parser->openExcelFile(file_name);
+		allocations += allocation_count - before;
+		state.PauseTiming();
+		parser->closeExcelFile(file_name);
+		state.ResumeTiming();
+	}
+	size_t cells = WorkbookGenerator::cellCount(shapeOf(state));
+	reportThroughput(state, file_name, cells);
+	state.counters["allocs_per_cell"] = static_cast<double>(allocations) / state.iterations() / cells;
+}
+BENCHMARK(BM_allocationsPerCell)->Args({100000, 10, 1, 10})->Args({1000, 1000, 1, 10})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,455 @@
+#include "ArrowExporter.hpp"
+
+#include <climits>
+#include <stdexcept>
+#include <vector>
+
+#include "CellReference.hpp"
+#include "SimdScan.hpp"
+
+using namespace excel_parser;
+
+namespace
+{
+	/**
+	 * @brief   Structural representation of the arrays of a column shorter than the sheet, copied to the full length.
+	 */
+	struct column_copy_t
+	{
+		std::vector<double> numbers;
+		std::vector<uint32_t> string_indices;
+		std::vector<uint64_t> number_mask;
+		std::vector<uint64_t> string_mask;
+	};
+
+	/**
+	 * @brief   Structural representation of the storage shared by every array of one export.
+	 */
+	struct export_state_t
+	{
+		/// Columnar sheet the buffers of the columns point into.
+		std::shared_ptr<const ColumnarSheet> columnar;
+		/// Shared strings the data of the dictionary points into.
+		std::shared_ptr<const SharedStringTable> shared_strings;
+		/// Whether the dictionary offsets and data have been built.
+		bool dictionary_built = false;
+		/// Whether the dictionary needs 64 bit offsets.
+		bool large_dictionary = false;
+		/// Offsets of the strings of the dictionary when 32 bits are enough.
+		std::vector<int32_t> offsets;
+		/// Offsets of the strings of the dictionary when 32 bits are not enough.
+		std::vector<int64_t> large_offsets;
+		/// Characters of the dictionary, only used when the arena of the shared strings is not in order.
+		std::string data;
+		/// Pointer to the characters of the dictionary.
+		const char *data_pointer = nullptr;
+		/// Copies of the columns shorter than the sheet.
+		std::vector<std::unique_ptr<column_copy_t>> copies;
+	};
+
+	/**
+	 * @brief   Structural representation of the storage owned by one exported array.
+	 */
+	struct array_holder_t
+	{
+		/// Storage shared by the export.
+		std::shared_ptr<export_state_t> state;
+		/// Buffers handed to the consumer.
+		std::vector<const void *> buffers;
+		/// Children handed to the consumer.
+		std::vector<ArrowArray *> children;
+		/// Storage of the children.
+		std::vector<std::unique_ptr<ArrowArray>> owned_children;
+		/// Storage of the dictionary.
+		std::unique_ptr<ArrowArray> dictionary;
+		/// Type ids of a union array.
+		std::vector<int8_t> type_ids;
+	};
+
+	/**
+	 * @brief   Structural representation of the storage owned by one exported schema.
+	 */
+	struct schema_holder_t
+	{
+		/// Format string of the type.
+		std::string format;
+		/// Name of the field.
+		std::string name;
+		/// Children handed to the consumer.
+		std::vector<ArrowSchema *> children;
+		/// Storage of the children.
+		std::vector<std::unique_ptr<ArrowSchema>> owned_children;
+		/// Storage of the dictionary.
+		std::unique_ptr<ArrowSchema> dictionary;
+	};
+
+	/**
+	 * @brief       Function releaseArray releases an array and every child and dictionary the consumer has not moved.
+	 * @param array array to be released.
+	 */
+	void releaseArray(ArrowArray *array)
+	{
+		array_holder_t *holder = static_cast<array_holder_t *>(array->private_data);
+		for (ArrowArray *child : holder->children)
+		{
+			if (child->release != nullptr)
+			{
+				child->release(child);
+			}
+		}
+		if (holder->dictionary != nullptr && holder->dictionary->release != nullptr)
+		{
+			holder->dictionary->release(holder->dictionary.get());
+		}
+		delete holder;
+		array->release = nullptr;
+	}
+
+	/**
+	 * @brief           Function releaseSchema releases a schema and every child and dictionary the consumer has not moved.
+	 * @param schema    schema to be released.
+	 */
+	void releaseSchema(ArrowSchema *schema)
+	{
+		schema_holder_t *holder = static_cast<schema_holder_t *>(schema->private_data);
+		for (ArrowSchema *child : holder->children)
+		{
+			if (child->release != nullptr)
+			{
+				child->release(child);
+			}
+		}
+		if (holder->dictionary != nullptr && holder->dictionary->release != nullptr)
+		{
+			holder->dictionary->release(holder->dictionary.get());
+		}
+		delete holder;
+		schema->release = nullptr;
+	}
+
+	/**
+	 * @brief           Function initialiseArray fills an array with a new holder and no buffers or children.
+	 * @param array     array to be filled.
+	 * @param state     storage shared by the export.
+	 * @param length    number of elements in the array.
+	 * @return          array_holder_t* holder of the array.
+	 */
+	array_holder_t *initialiseArray(ArrowArray *array, std::shared_ptr<export_state_t> state, int64_t length)
+	{
+		array_holder_t *holder = new array_holder_t();
+		holder->state = std::move(state);
+		*array = ArrowArray{length, 0, 0, 0, 0, nullptr, nullptr, nullptr, &releaseArray, holder};
+		return holder;
+	}
+
+	/**
+	 * @brief           Function initialiseSchema fills a schema with a new holder and no children.
+	 * @param schema    schema to be filled.
+	 * @param format    format string of the type.
+	 * @param name      name of the field.
+	 * @return          schema_holder_t* holder of the schema.
+	 */
+	schema_holder_t *initialiseSchema(ArrowSchema *schema, std::string format, std::string name)
+	{
+		schema_holder_t *holder = new schema_holder_t();
+		holder->format = std::move(format);
+		holder->name = std::move(name);
+		*schema = ArrowSchema{holder->format.c_str(), holder->name.c_str(), nullptr, ARROW_FLAG_NULLABLE, 0, nullptr, nullptr, &releaseSchema, holder};
+		return holder;
+	}
+
+	/**
+	 * @brief           Function finishArray attaches the buffers and children of a holder to its array.
+	 * @param array     array to be finished.
+	 */
+	void finishArray(ArrowArray *array)
+	{
+		array_holder_t *holder = static_cast<array_holder_t *>(array->private_data);
+		array->n_buffers = static_cast<int64_t>(holder->buffers.size());
+		array->buffers = holder->buffers.data();
+		array->n_children = static_cast<int64_t>(holder->children.size());
+		array->children = holder->children.empty() ? nullptr : holder->children.data();
+		array->dictionary = holder->dictionary.get();
+	}
+
+	/**
+	 * @brief           Function finishSchema attaches the children of a holder to its schema.
+	 * @param schema    schema to be finished.
+	 */
+	void finishSchema(ArrowSchema *schema)
+	{
+		schema_holder_t *holder = static_cast<schema_holder_t *>(schema->private_data);
+		schema->n_children = static_cast<int64_t>(holder->children.size());
+		schema->children = holder->children.empty() ? nullptr : holder->children.data();
+		schema->dictionary = holder->dictionary.get();
+	}
+
+	/**
+	 * @brief       Function countNulls counts the rows of an array whose bit is clear in a bitmap.
+	 * @param mask  bitmap of the valid rows.
+	 * @param rows  number of rows in the array.
+	 * @return      int64_t number of null rows.
+	 */
+	int64_t countNulls(const uint64_t *mask, size_t rows)
+	{
+		size_t valid = 0;
+		for (size_t word = 0; word < (rows >> 6); ++word)
+		{
+			valid += simd::countSetBits(mask[word]);
+		}
+		if ((rows & 63) != 0)
+		{
+			valid += simd::countSetBits(mask[rows >> 6] & ((uint64_t(1) << (rows & 63)) - 1));
+		}
+		return static_cast<int64_t>(rows - valid);
+	}
+
+	/**
+	 * @brief       Function buildDictionary builds the offsets of the strings of the dictionary of an export.
+	 * @details     The arena is used as the data of the dictionary when every string follows the one before it, which
+	 *              holds unless identical strings were interned, in which case the strings are copied out in order.
+	 * @param state storage shared by the export.
+	 */
+	void buildDictionary(export_state_t &state)
+	{
+		if (state.dictionary_built)
+		{
+			return;
+		}
+		const SharedStringTable &table = *state.shared_strings;
+		size_t total = 0;
+		bool in_order = true;
+		const char *base = table.size() == 0 ? nullptr : table.at(0).data();
+		for (size_t i = 0; i < table.size(); ++i)
+		{
+			std::string_view s = table.at(i);
+			in_order = in_order && s.data() == base + total;
+			total += s.size();
+		}
+		if (!in_order)
+		{
+			state.data.reserve(total);
+			for (size_t i = 0; i < table.size(); ++i)
+			{
+				state.data.append(table.at(i));
+			}
+			base = state.data.data();
+		}
+		state.data_pointer = base == nullptr ? "" : base;
+		state.large_dictionary = total > static_cast<size_t>(INT32_MAX);
+
+		int64_t offset = 0;
+		if (state.large_dictionary)
+		{
+			state.large_offsets.reserve(table.size() + 1);
+			state.large_offsets.push_back(0);
+		}
+		else
+		{
+			state.offsets.reserve(table.size() + 1);
+			state.offsets.push_back(0);
+		}
+		for (size_t i = 0; i < table.size(); ++i)
+		{
+			offset += static_cast<int64_t>(table.at(i).size());
+			if (state.large_dictionary)
+			{
+				state.large_offsets.push_back(offset);
+			}
+			else
+			{
+				state.offsets.push_back(static_cast<int32_t>(offset));
+			}
+		}
+		state.dictionary_built = true;
+	}
+
+	/**
+	 * @brief           Function exportNumbers fills an array and schema with the numbers of a column as float64.
+	 * @param state     storage shared by the export.
+	 * @param numbers   values of the rows.
+	 * @param mask      bitmap of the rows holding a number.
+	 * @param rows      number of rows in the array.
+	 * @param name      name of the field.
+	 * @param array     array to be filled.
+	 * @param schema    schema to be filled.
+	 */
+	void exportNumbers(std::shared_ptr<export_state_t> state, const double *numbers, const uint64_t *mask, size_t rows, const std::string &name, ArrowArray *array, ArrowSchema *schema)
+	{
+		array_holder_t *holder = initialiseArray(array, std::move(state), static_cast<int64_t>(rows));
+		array->null_count = countNulls(mask, rows);
+		holder->buffers = {mask, numbers};
+		finishArray(array);
+		initialiseSchema(schema, "g", name);
+		finishSchema(schema);
+	}
+
+	/**
+	 * @brief           Function exportNulls fills an array and schema with a column that holds no cells, which has no
+	 *                  buffers at all.
+	 * @param state     storage shared by the export.
+	 * @param rows      number of rows in the array.
+	 * @param name      name of the field.
+	 * @param array     array to be filled.
+	 * @param schema    schema to be filled.
+	 */
+	void exportNulls(std::shared_ptr<export_state_t> state, size_t rows, const std::string &name, ArrowArray *array, ArrowSchema *schema)
+	{
+		initialiseArray(array, std::move(state), static_cast<int64_t>(rows));
+		array->null_count = static_cast<int64_t>(rows);
+		finishArray(array);
+		initialiseSchema(schema, "n", name);
+		finishSchema(schema);
+	}
+
+	/**
+	 * @brief           Function exportStrings fills an array and schema with the strings of a column as int32 indices
+	 *                  into a dictionary of the shared strings.
+	 * @param state     storage shared by the export.
+	 * @param indices   shared string indices of the rows.
+	 * @param mask      bitmap of the rows holding a string.
+	 * @param rows      number of rows in the array.
+	 * @param name      name of the field.
+	 * @param array     array to be filled.
+	 * @param schema    schema to be filled.
+	 */
+	void exportStrings(std::shared_ptr<export_state_t> state, const uint32_t *indices, const uint64_t *mask, size_t rows, const std::string &name, ArrowArray *array, ArrowSchema *schema)
+	{
+		buildDictionary(*state);
+		const export_state_t &shared = *state;
+		int64_t strings = static_cast<int64_t>(shared.shared_strings->size());
+
+		array_holder_t *holder = initialiseArray(array, state, static_cast<int64_t>(rows));
+		array->null_count = countNulls(mask, rows);
+		holder->buffers = {mask, indices};
+		holder->dictionary.reset(new ArrowArray());
+		array_holder_t *dictionary = initialiseArray(holder->dictionary.get(), state, strings);
+		const void *offsets = shared.large_dictionary ? static_cast<const void *>(shared.large_offsets.data()) : static_cast<const void *>(shared.offsets.data());
+		dictionary->buffers = {nullptr, offsets, shared.data_pointer};
+		finishArray(holder->dictionary.get());
+		finishArray(array);
+
+		schema_holder_t *schema_holder = initialiseSchema(schema, "i", name);
+		schema_holder->dictionary.reset(new ArrowSchema());
+		initialiseSchema(schema_holder->dictionary.get(), shared.large_dictionary ? "U" : "u", "");
+		schema_holder->dictionary->flags = 0;
+		finishSchema(schema_holder->dictionary.get());
+		finishSchema(schema);
+	}
+}
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+void ArrowExporter::exportSheet(std::shared_ptr<const ColumnarSheet> columnar, std::shared_ptr<const SharedStringTable> shared_strings, const std::string &name, ArrowArray *array, ArrowSchema *schema)
+{
+	const size_t rows = columnar->getRowCount();
+	const size_t words = (rows + 63) >> 6;
+	if (shared_strings != nullptr && shared_strings->size() > static_cast<size_t>(INT32_MAX))
+	{
+		throw std::runtime_error("[Excel Parser] (ERROR) Too many shared strings to be indexed by an Arrow dictionary.");
+	}
+	for (size_t i = 0; i < columnar->getColumnCount(); ++i)
+	{
+		const std::vector<uint64_t> &mask = columnar->getColumn(i).getStringMask();
+		for (size_t word = 0; shared_strings == nullptr && word < mask.size(); ++word)
+		{
+			if (mask[word] != 0)
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Shared strings are required to export column " + columnName(static_cast<int>(i)) + " to Arrow.");
+			}
+		}
+	}
+
+	std::shared_ptr<export_state_t> state = std::make_shared<export_state_t>();
+	state->columnar = columnar;
+	state->shared_strings = shared_strings;
+
+	array_holder_t *holder = initialiseArray(array, state, static_cast<int64_t>(rows));
+	schema_holder_t *schema_holder = initialiseSchema(schema, "+s", name);
+	schema->flags = 0;
+	holder->buffers = {nullptr};
+	for (size_t i = 0; i < columnar->getColumnCount(); ++i)
+	{
+		const ColumnarSheet::Column &column = columnar->getColumn(i);
+		holder->owned_children.emplace_back(new ArrowArray());
+		schema_holder->owned_children.emplace_back(new ArrowSchema());
+		ArrowArray *child = holder->owned_children.back().get();
+		ArrowSchema *child_schema = schema_holder->owned_children.back().get();
+		holder->children.push_back(child);
+		schema_holder->children.push_back(child_schema);
+
+		std::string column_name = columnName(static_cast<int>(i));
+		if (column.size() == 0)
+		{
+			exportNulls(state, rows, column_name, child, child_schema);
+			continue;
+		}
+
+		// Columns only reach the end of the sheet when cells are added to them, so a column of a sheet built row by
+		// row may be shorter and is copied out to the full length instead.
+		const double *numbers = column.getNumbers();
+		const uint32_t *indices = column.getStringIndices();
+		const uint64_t *number_mask = column.getNumberMask().data();
+		const uint64_t *string_mask = column.getStringMask().data();
+		if (column.size() < rows || column.getNumberMask().size() < words)
+		{
+			state->copies.emplace_back(new column_copy_t());
+			column_copy_t *copies = state->copies.back().get();
+			copies->numbers.assign(numbers, numbers + column.size());
+			copies->numbers.resize(rows, 0);
+			copies->string_indices.assign(indices, indices + column.size());
+			copies->string_indices.resize(rows, 0);
+			copies->number_mask = column.getNumberMask();
+			copies->number_mask.resize(words, 0);
+			copies->string_mask = column.getStringMask();
+			copies->string_mask.resize(words, 0);
+			numbers = copies->numbers.data();
+			indices = copies->string_indices.data();
+			number_mask = copies->number_mask.data();
+			string_mask = copies->string_mask.data();
+		}
+
+		bool has_numbers = false;
+		bool has_strings = false;
+		for (size_t word = 0; word < words; ++word)
+		{
+			has_numbers = has_numbers || number_mask[word] != 0;
+			has_strings = has_strings || string_mask[word] != 0;
+		}
+
+		if (!has_strings)
+		{
+			exportNumbers(state, numbers, number_mask, rows, column_name, child, child_schema);
+		}
+		else if (!has_numbers)
+		{
+			exportStrings(state, indices, string_mask, rows, column_name, child, child_schema);
+		}
+		else
+		{
+			// A sparse union holds no nulls of its own, so empty rows select the number child, where they are null.
+			array_holder_t *union_holder = initialiseArray(child, state, static_cast<int64_t>(rows));
+			union_holder->type_ids.resize(rows, 0);
+			for (size_t row = 0; row < rows; ++row)
+			{
+				union_holder->type_ids[row] = static_cast<int8_t>((string_mask[row >> 6] >> (row & 63)) & 1);
+			}
+			union_holder->buffers = {union_holder->type_ids.data()};
+			schema_holder_t *union_schema = initialiseSchema(child_schema, "+us:0,1", column_name);
+			for (size_t k = 0; k < 2; ++k)
+			{
+				union_holder->owned_children.emplace_back(new ArrowArray());
+				union_schema->owned_children.emplace_back(new ArrowSchema());
+				union_holder->children.push_back(union_holder->owned_children.back().get());
+				union_schema->children.push_back(union_schema->owned_children.back().get());
+			}
+			exportNumbers(state, numbers, number_mask, rows, "number", union_holder->children[0], union_schema->children[0]);
+			exportStrings(state, indices, string_mask, rows, "string", union_holder->children[1], union_schema->children[1]);
+			finishArray(child);
+			finishSchema(child_schema);
+		}
+	}
+	finishArray(array);
+	finishSchema(schema);
+}
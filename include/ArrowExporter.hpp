@@ -0,0 +1,95 @@
+/**
+ * @file    ArrowExporter.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the ArrowExporter, which exposes a ColumnarSheet through the Apache
+ *          Arrow C Data Interface.
+ * @details The structures of the interface are declared here as the specification requires, so no Arrow library is
+ *          needed to produce the arrays, and any Arrow implementation can import them. The arrays point straight
+ *          into the columns of the ColumnarSheet and the arena of the SharedStringTable, which the exported arrays
+ *          keep alive until they are released.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef ArrowExporter_HPP
+#define ArrowExporter_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ColumnarSheet.hpp"
+#include "SharedStringTable.hpp"
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+/**
+ * @brief   Structural representation of the type of an Arrow array, as defined by the Arrow C Data Interface.
+ */
+struct ArrowSchema
+{
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+/**
+ * @brief   Structural representation of the data of an Arrow array, as defined by the Arrow C Data Interface.
+ */
+struct ArrowArray
+{
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+namespace excel_parser
+{
+    /**
+     * @brief   Class ArrowExporter exports the columns of a sheet as an Arrow struct array with one field per column.
+     * @details Row i of the array is row getFirstRow() + i of the sheet, and each field is named after the letters of
+     *          its column. Columns holding only numbers are exported as float64, columns holding only strings as
+     *          int32 indices into a utf8 dictionary of the shared strings, and columns holding both as a sparse
+     *          union of the two. Empty cells are null, and columns without any cells are of the null type, which has
+     *          no buffers. The values, indices, and presence bitmaps are the arrays of the columns themselves, and the
+     *          dictionary is the arena of the shared strings unless interned strings have left it out of order, so
+     *          only the offsets of the dictionary and the type ids of union columns are built. The bitmaps are only
+     *          laid out as Arrow expects on little endian hosts.
+     */
+    class ArrowExporter
+    {
+    public:
+        /**
+         * @brief                   Method exportSheet fills an Arrow array and schema with the columns of a sheet.
+         * @param columnar          columnar representation of the sheet, which is kept alive by the array.
+         * @param shared_strings    shared strings of the file the sheet is in, which are kept alive by the array.
+         * @param name              name given to the struct field of the schema.
+         * @param array             array to be filled, which the caller must release.
+         * @param schema            schema to be filled, which the caller must release.
+         * @throws                  std::runtime_error if the sheet holds strings but no shared strings are given.
+         */
+        static void exportSheet(std::shared_ptr<const ColumnarSheet> columnar, std::shared_ptr<const SharedStringTable> shared_strings, const std::string &name, ArrowArray *array, ArrowSchema *schema);
+    };
+}
+
+#endif /* ArrowExporter_HPP */
@@ -0,0 +1,55 @@
+#include "CellReference.hpp"
+
+#include <cctype>
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC FUNCTIONS *************************************************************************************************
+ ********************************************************************************************************************/
+std::string excel_parser::columnName(int column_index)
+{
+	std::string name;
+	for (int i = column_index + 1; i > 0; i = (i - 1) / 26)
+	{
+		name.insert(name.begin(), static_cast<char>('A' + (i - 1) % 26));
+	}
+	return name;
+}
+
+std::string excel_parser::cellReference(int row_id, int column_index)
+{
+	return columnName(column_index) + std::to_string(row_id);
+}
+
+bool excel_parser::parseCellReference(std::string_view reference, int &row_id, int &column_index)
+{
+	size_t letters = 0;
+	while (letters < reference.size() && isColumnLetter(reference[letters]))
+	{
+		++letters;
+	}
+	int column = columnIndex(reference.substr(0, letters));
+	if (column < 0)
+	{
+		return false;
+	}
+	size_t i = letters;
+	int row = 0;
+	for (; i < reference.size() && std::isdigit(static_cast<unsigned char>(reference[i])); ++i)
+	{
+		row = row * 10 + (reference[i] - '0');
+		if (row > max_row_id)
+		{
+			return false;
+		}
+	}
+	// Rows are numbered from 1, so "A0" names no cell.
+	if (i == letters || i != reference.size() || row == 0)
+	{
+		return false;
+	}
+	row_id = row;
+	column_index = column;
+	return true;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file    CellReference.hpp
+ * @author  James Horner
+ * @brief   This file contains the declarations of the functions converting between Excel cell references and indices.
+ * @details Cells are stored by the number of their row and the 0 based index of their column, so these functions
+ *          convert to and from the "A1" notation used by Excel.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef CellReference_HPP
+#define CellReference_HPP
+
+#include <string>
+#include <string_view>
+
+namespace excel_parser
+{
+    /// Largest 0 based column index of a worksheet, that of column "XFD".
+    constexpr int max_column_index = 16383;
+    /// Largest row number of a worksheet.
+    constexpr int max_row_id = 1048576;
+
+    /**
+     * @brief       Function isColumnLetter checks whether a character can be part of the letters of a column.
+     * @param c     character to be checked.
+     * @return      true if the character is an ASCII letter in either case.
+     */
+    constexpr bool isColumnLetter(char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); }
+
+    /**
+     * @brief               Function columnIndex converts Excel column letters into a 0 based column index.
+     * @param column_name   column letters (e.g. "A" or "AB") in either case.
+     * @return              int index of the column ("A" is 0), or -1 if the name is empty, holds anything other than
+     *                      letters, or is past column "XFD".
+     * @note                This is the only place column letters are decoded, so every reader of references agrees
+     *                      on which columns exist.
+     */
+    constexpr int columnIndex(std::string_view column_name)
+    {
+        int index = 0;
+        for (char c : column_name)
+        {
+            if (!isColumnLetter(c))
+            {
+                return -1;
+            }
+            index = index * 26 + ((c >= 'a' ? c - 'a' : c - 'A') + 1);
+            // Stopping past the last column also keeps the index from overflowing on long names.
+            if (index > max_column_index + 1)
+            {
+                return -1;
+            }
+        }
+        return index - 1;
+    }
+
+    /**
+     * @brief               Function columnName converts a 0 based column index into Excel column letters.
+     * @param column_index  index of the column ("A" is 0).
+     * @return              std::string column letters.
+     */
+    std::string columnName(int column_index);
+
+    /**
+     * @brief               Function cellReference converts a row number and column index into "A1" notation.
+     * @param row_id        number of the row.
+     * @param column_index  0 based index of the column.
+     * @return              std::string reference to the cell (e.g. "B3").
+     */
+    std::string cellReference(int row_id, int column_index);
+
+    /**
+     * @brief               Function parseCellReference converts a reference in "A1" notation into a row number and
+     *                      column index in a single pass without allocating.
+     * @param reference     reference to the cell (e.g. "B3"), with the column letters in either case.
+     * @param row_id        set to the number of the row on success.
+     * @param column_index  set to the 0 based index of the column on success.
+     * @return              true if the reference is one or more letters followed by one or more digits, naming a
+     *                      column no further than "XFD" and a row from 1 to max_row_id.
+     */
+    bool parseCellReference(std::string_view reference, int &row_id, int &column_index);
+}
+
+#endif /* CellReference_HPP */
@@ -0,0 +1,126 @@
+#include "ColumnIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+ColumnIndex ColumnIndex::build(const sheet &s, std::shared_ptr<const SharedStringTable> shared_strings, int column_index, IndexType type)
+{
+	ColumnIndex index(column_index, type);
+	index.shared_strings = std::move(shared_strings);
+	for (auto &r : s)
+	{
+		const cell_t *c = r.second.find(column_index);
+		if (c == nullptr)
+		{
+			continue;
+		}
+		if (c->type == NUMBER)
+		{
+			// NaN never compares equal to anything, so it could never be found.
+			if (std::isnan(c->getNumber()))
+			{
+				continue;
+			}
+			if (type == HASH_INDEX)
+			{
+				index.number_rows[c->getNumber()].push_back(r.first);
+			}
+			else
+			{
+				index.sorted_numbers.emplace_back(c->getNumber(), r.first);
+			}
+		}
+		else if (c->type == STRING)
+		{
+			if (index.shared_strings == nullptr || !index.shared_strings->contains(c->getStringIndex()))
+			{
+				continue;
+			}
+			std::string_view value = index.shared_strings->at(c->getStringIndex());
+			if (type == HASH_INDEX)
+			{
+				index.string_rows[value].push_back(r.first);
+			}
+			else
+			{
+				index.sorted_strings.emplace_back(value, r.first);
+			}
+		}
+		else
+		{
+			// Only numbers and shared strings are indexed, so INLINE_STRING and ERROR cells are never found.
+			continue;
+		}
+		++index.cell_count;
+	}
+
+	// The rows were visited in order, so a stable sort by value leaves the rows of each value in row order.
+	std::stable_sort(index.sorted_numbers.begin(), index.sorted_numbers.end(), [](const std::pair<double, int> &a, const std::pair<double, int> &b)
+					 { return a.first < b.first; });
+	std::stable_sort(index.sorted_strings.begin(), index.sorted_strings.end(), [](const std::pair<std::string_view, int> &a, const std::pair<std::string_view, int> &b)
+					 { return a.first < b.first; });
+
+	// The index never changes once built, so it is measured once here. Each hash map node holds its value along with
+	// a pointer to the next node and the cached hash.
+	const size_t node_overhead = 2 * sizeof(void *);
+	index.memory_usage = sizeof(ColumnIndex) + (index.number_rows.bucket_count() + index.string_rows.bucket_count()) * sizeof(void *) +
+						 index.sorted_numbers.capacity() * sizeof(std::pair<double, int>) + index.sorted_strings.capacity() * sizeof(std::pair<std::string_view, int>);
+	for (auto &value_rows : index.number_rows)
+	{
+		index.memory_usage += node_overhead + sizeof(value_rows) + value_rows.second.capacity() * sizeof(int);
+	}
+	for (auto &value_rows : index.string_rows)
+	{
+		index.memory_usage += node_overhead + sizeof(value_rows) + value_rows.second.capacity() * sizeof(int);
+	}
+	return index;
+}
+
+std::vector<int> ColumnIndex::findEqual(double value) const
+{
+	if (type == HASH_INDEX)
+	{
+		auto it = number_rows.find(value);
+		return it == number_rows.end() ? std::vector<int>() : it->second;
+	}
+	return findRange(value, value);
+}
+
+std::vector<int> ColumnIndex::findEqual(std::string_view value) const
+{
+	if (type == HASH_INDEX)
+	{
+		auto it = string_rows.find(value);
+		return it == string_rows.end() ? std::vector<int>() : it->second;
+	}
+	auto first = std::lower_bound(sorted_strings.begin(), sorted_strings.end(), value, [](const std::pair<std::string_view, int> &entry, std::string_view v)
+								  { return entry.first < v; });
+	std::vector<int> rows;
+	for (auto it = first; it != sorted_strings.end() && it->first == value; ++it)
+	{
+		rows.push_back(it->second);
+	}
+	return rows;
+}
+
+std::vector<int> ColumnIndex::findRange(double low, double high) const
+{
+	if (type != SORTED_INDEX)
+	{
+		throw std::runtime_error("[Excel Parser] (ERROR) Range lookups require a sorted index of column " + columnName(column_index));
+	}
+	auto first = std::lower_bound(sorted_numbers.begin(), sorted_numbers.end(), low, [](const std::pair<double, int> &entry, double v)
+								  { return entry.first < v; });
+	std::vector<int> rows;
+	for (auto it = first; it != sorted_numbers.end() && it->first <= high; ++it)
+	{
+		rows.push_back(it->second);
+	}
+	return rows;
+}
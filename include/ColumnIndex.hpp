@@ -0,0 +1,133 @@
+/**
+ * @file    ColumnIndex.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the ColumnIndex, a secondary index over the values of a column of a
+ *          sheet.
+ * @details A ColumnIndex maps the values of a column to the numbers of the rows holding them, so finding the rows
+ *          where a column equals a value does not scan the sheet or resolve a shared string per cell.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef ColumnIndex_HPP
+#define ColumnIndex_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ExcelTypes.hpp"
+#include "SharedStringTable.hpp"
+
+namespace excel_parser
+{
+    /**
+     * @brief Enumeration of the different structures a column index can be built with.
+     */
+    typedef enum
+    {
+        /// Hash tables of the values, answering equality lookups in constant time.
+        HASH_INDEX,
+        /// Arrays of the values in sorted order, answering equality and numeric range lookups in logarithmic time.
+        SORTED_INDEX
+    } IndexType;
+
+    /**
+     * @brief   Class ColumnIndex is an immutable index of the values of one column of a sheet.
+     * @details NUMBER cells are indexed by their value and STRING cells by the text of their shared string, so a
+     *          lookup never needs the string index. Rows are returned in row order for equality lookups.
+     */
+    class ColumnIndex
+    {
+    public:
+        /**
+         * @brief                   Method build indexes a column of a sheet.
+         * @param s                 sheet holding the column.
+         * @param shared_strings    shared strings of the file the sheet is in, which are kept alive by the index.
+         * @param column_index      0 based index of the column.
+         * @param type              structure the index is built with.
+         * @return                  ColumnIndex the index of the column.
+         */
+        static ColumnIndex build(const sheet &s, std::shared_ptr<const SharedStringTable> shared_strings, int column_index, IndexType type);
+
+        /**
+         * @brief   Method getType retrieves the structure the index was built with.
+         * @return  IndexType structure of the index.
+         */
+        IndexType getType() const { return type; }
+
+        /**
+         * @brief   Method getColumnIndex retrieves the column the index was built over.
+         * @return  int 0 based index of the column.
+         */
+        int getColumnIndex() const { return column_index; }
+
+        /**
+         * @brief   Method size retrieves the number of cells in the index.
+         * @return  size_t number of NUMBER and STRING cells in the column.
+         */
+        size_t size() const { return cell_count; }
+
+        /**
+         * @brief       Method findEqual finds the rows where the column holds a number.
+         * @param value numeric value to search for.
+         * @return      std::vector<int> numbers of the matching rows in row order.
+         */
+        std::vector<int> findEqual(double value) const;
+
+        /**
+         * @brief       Method findEqual finds the rows where the column holds a string.
+         * @param value text to search for.
+         * @return      std::vector<int> numbers of the matching rows in row order.
+         */
+        std::vector<int> findEqual(std::string_view value) const;
+
+        /**
+         * @brief       Method findRange finds the rows where the column holds a number in a closed range.
+         * @param low   lowest value to be included.
+         * @param high  highest value to be included.
+         * @return      std::vector<int> numbers of the matching rows in order of value, then row.
+         * @throws      std::runtime_error if the index is not a SORTED_INDEX.
+         */
+        std::vector<int> findRange(double low, double high) const;
+
+        /**
+         * @brief   Method getMemoryUsage estimates the number of bytes allocated for the index.
+         * @return  size_t bytes allocated by the index, including the nodes and buckets of its hash maps but not the
+         *          shared strings its keys are views of.
+         */
+        size_t getMemoryUsage() const { return memory_usage; }
+
+    private:
+        /**
+         * @brief               Constructor for the ColumnIndex class only to be used by the build method.
+         * @param column_index  0 based index of the column.
+         * @param type          structure the index is built with.
+         */
+        ColumnIndex(int column_index, IndexType type) : column_index(column_index), type(type), cell_count(0), memory_usage(0) {}
+
+        /// 0 based index of the column.
+        int column_index;
+        /// Structure of the index.
+        IndexType type;
+        /// Number of cells in the index.
+        size_t cell_count;
+        /// Estimated bytes allocated by the index.
+        size_t memory_usage;
+        /// Shared strings the string keys are views of.
+        std::shared_ptr<const SharedStringTable> shared_strings;
+        /// Rows holding each numeric value, used by a HASH_INDEX.
+        std::unordered_map<double, std::vector<int>> number_rows;
+        /// Rows holding each string, used by a HASH_INDEX.
+        std::unordered_map<std::string_view, std::vector<int>> string_rows;
+        /// Pairs of numeric values and rows sorted by value then row, used by a SORTED_INDEX.
+        std::vector<std::pair<double, int>> sorted_numbers;
+        /// Pairs of strings and rows sorted by string then row, used by a SORTED_INDEX.
+        std::vector<std::pair<std::string_view, int>> sorted_strings;
+    };
+}
+
+#endif /* ColumnIndex_HPP */
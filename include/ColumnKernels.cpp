@@ -0,0 +1,288 @@
+#include "ColumnKernels.hpp"
+
+#include "SimdScan.hpp"
+
+using namespace excel_parser;
+
+namespace
+{
+	/// Number of rows covered by each word of a bitmap.
+	constexpr size_t WORD_ROWS = 64;
+
+#if defined(__AVX2__)
+	/**
+	 * @brief   Structural representation of the running aggregates of the dense words of a column, four lanes wide.
+	 */
+	struct dense_accumulator_t
+	{
+		__m256d sum[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+		__m256d min = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+		__m256d max = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+		size_t count = 0;
+
+		/**
+		 * @brief           Method add accumulates the values of 64 rows that all hold a number.
+		 * @param numbers   pointer to the values of the first row.
+		 */
+		void add(const double *numbers)
+		{
+			// Independent sums hide the latency of the additions.
+			for (size_t i = 0; i < WORD_ROWS; i += 16)
+			{
+				for (size_t k = 0; k < 4; ++k)
+				{
+					__m256d value = _mm256_loadu_pd(numbers + i + 4 * k);
+					sum[k] = _mm256_add_pd(sum[k], value);
+					min = _mm256_min_pd(value, min);
+					max = _mm256_max_pd(value, max);
+				}
+			}
+			count += WORD_ROWS;
+		}
+
+		/**
+		 * @brief   Method finish reduces the lanes of the accumulator.
+		 * @return  aggregate_t aggregates of every row added.
+		 */
+		aggregate_t finish() const
+		{
+			alignas(32) double sums[4];
+			alignas(32) double mins[4];
+			alignas(32) double maxes[4];
+			_mm256_store_pd(sums, _mm256_add_pd(_mm256_add_pd(sum[0], sum[1]), _mm256_add_pd(sum[2], sum[3])));
+			_mm256_store_pd(mins, min);
+			_mm256_store_pd(maxes, max);
+			aggregate_t result;
+			result.count = count;
+			result.sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+			for (size_t i = 0; i < 4; ++i)
+			{
+				result.min = mins[i] < result.min ? mins[i] : result.min;
+				result.max = maxes[i] > result.max ? maxes[i] : result.max;
+			}
+			return result;
+		}
+	};
+
+	/**
+	 * @brief           Function filterDense finds the values of 64 rows that are in a closed range.
+	 * @param numbers   pointer to the values of the first row.
+	 * @param low       lowest value to be included.
+	 * @param high      highest value to be included.
+	 * @return          uint64_t bitmap of the matching rows.
+	 */
+	uint64_t filterDense(const double *numbers, double low, double high)
+	{
+		const __m256d wide_low = _mm256_set1_pd(low);
+		const __m256d wide_high = _mm256_set1_pd(high);
+		uint64_t bits = 0;
+		for (size_t i = 0; i < WORD_ROWS; i += 4)
+		{
+			__m256d value = _mm256_loadu_pd(numbers + i);
+			__m256d matches = _mm256_and_pd(_mm256_cmp_pd(value, wide_low, _CMP_GE_OQ), _mm256_cmp_pd(value, wide_high, _CMP_LE_OQ));
+			bits |= static_cast<uint64_t>(_mm256_movemask_pd(matches)) << i;
+		}
+		return bits;
+	}
+#elif defined(__SSE2__) || defined(_M_X64)
+	struct dense_accumulator_t
+	{
+		__m128d sum[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+		__m128d min = _mm_set1_pd(std::numeric_limits<double>::infinity());
+		__m128d max = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+		size_t count = 0;
+
+		void add(const double *numbers)
+		{
+			for (size_t i = 0; i < WORD_ROWS; i += 8)
+			{
+				for (size_t k = 0; k < 4; ++k)
+				{
+					__m128d value = _mm_loadu_pd(numbers + i + 2 * k);
+					sum[k] = _mm_add_pd(sum[k], value);
+					min = _mm_min_pd(value, min);
+					max = _mm_max_pd(value, max);
+				}
+			}
+			count += WORD_ROWS;
+		}
+
+		aggregate_t finish() const
+		{
+			alignas(16) double sums[2];
+			alignas(16) double mins[2];
+			alignas(16) double maxes[2];
+			_mm_store_pd(sums, _mm_add_pd(_mm_add_pd(sum[0], sum[1]), _mm_add_pd(sum[2], sum[3])));
+			_mm_store_pd(mins, min);
+			_mm_store_pd(maxes, max);
+			aggregate_t result;
+			result.count = count;
+			result.sum = sums[0] + sums[1];
+			result.min = mins[0] < mins[1] ? mins[0] : mins[1];
+			result.max = maxes[0] > maxes[1] ? maxes[0] : maxes[1];
+			return result;
+		}
+	};
+
+	uint64_t filterDense(const double *numbers, double low, double high)
+	{
+		const __m128d wide_low = _mm_set1_pd(low);
+		const __m128d wide_high = _mm_set1_pd(high);
+		uint64_t bits = 0;
+		for (size_t i = 0; i < WORD_ROWS; i += 2)
+		{
+			__m128d value = _mm_loadu_pd(numbers + i);
+			__m128d matches = _mm_and_pd(_mm_cmpge_pd(value, wide_low), _mm_cmple_pd(value, wide_high));
+			bits |= static_cast<uint64_t>(_mm_movemask_pd(matches)) << i;
+		}
+		return bits;
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	struct dense_accumulator_t
+	{
+		float64x2_t sum[4] = {vdupq_n_f64(0), vdupq_n_f64(0), vdupq_n_f64(0), vdupq_n_f64(0)};
+		float64x2_t min = vdupq_n_f64(std::numeric_limits<double>::infinity());
+		float64x2_t max = vdupq_n_f64(-std::numeric_limits<double>::infinity());
+		size_t count = 0;
+
+		void add(const double *numbers)
+		{
+			for (size_t i = 0; i < WORD_ROWS; i += 8)
+			{
+				for (size_t k = 0; k < 4; ++k)
+				{
+					float64x2_t value = vld1q_f64(numbers + i + 2 * k);
+					sum[k] = vaddq_f64(sum[k], value);
+					min = vminnmq_f64(value, min);
+					max = vmaxnmq_f64(value, max);
+				}
+			}
+			count += WORD_ROWS;
+		}
+
+		aggregate_t finish() const
+		{
+			aggregate_t result;
+			result.count = count;
+			result.sum = vaddvq_f64(vaddq_f64(vaddq_f64(sum[0], sum[1]), vaddq_f64(sum[2], sum[3])));
+			result.min = vminnmvq_f64(min);
+			result.max = vmaxnmvq_f64(max);
+			return result;
+		}
+	};
+
+	uint64_t filterDense(const double *numbers, double low, double high)
+	{
+		const float64x2_t wide_low = vdupq_n_f64(low);
+		const float64x2_t wide_high = vdupq_n_f64(high);
+		uint64_t bits = 0;
+		for (size_t i = 0; i < WORD_ROWS; i += 2)
+		{
+			float64x2_t value = vld1q_f64(numbers + i);
+			uint64x2_t matches = vandq_u64(vcgeq_f64(value, wide_low), vcleq_f64(value, wide_high));
+			bits |= ((vgetq_lane_u64(matches, 0) & 1) << i) | ((vgetq_lane_u64(matches, 1) & 1) << (i + 1));
+		}
+		return bits;
+	}
+#else
+	struct dense_accumulator_t
+	{
+		double sum[4] = {0, 0, 0, 0};
+		double min = std::numeric_limits<double>::infinity();
+		double max = -std::numeric_limits<double>::infinity();
+		size_t count = 0;
+
+		void add(const double *numbers)
+		{
+			for (size_t i = 0; i < WORD_ROWS; i += 4)
+			{
+				for (size_t k = 0; k < 4; ++k)
+				{
+					double value = numbers[i + k];
+					sum[k] += value;
+					min = value < min ? value : min;
+					max = value > max ? value : max;
+				}
+			}
+			count += WORD_ROWS;
+		}
+
+		aggregate_t finish() const
+		{
+			aggregate_t result;
+			result.count = count;
+			result.sum = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+			result.min = min;
+			result.max = max;
+			return result;
+		}
+	};
+
+	uint64_t filterDense(const double *numbers, double low, double high)
+	{
+		uint64_t bits = 0;
+		for (size_t i = 0; i < WORD_ROWS; ++i)
+		{
+			bits |= static_cast<uint64_t>(numbers[i] >= low && numbers[i] <= high) << i;
+		}
+		return bits;
+	}
+#endif
+}
+
+/********************************************************************************************************************
+ * PUBLIC FUNCTIONS *************************************************************************************************
+ ********************************************************************************************************************/
+aggregate_t simd::aggregateNumbers(const double *numbers, size_t size, const uint64_t *mask, const uint64_t *selection, size_t first_word, size_t last_word)
+{
+	dense_accumulator_t dense;
+	aggregate_t sparse;
+	for (size_t word = first_word; word < last_word; ++word)
+	{
+		uint64_t bits = selection == nullptr ? mask[word] : mask[word] & selection[word];
+		const double *block = numbers + word * WORD_ROWS;
+		if (bits == ~uint64_t(0) && (word + 1) * WORD_ROWS <= size)
+		{
+			dense.add(block);
+			continue;
+		}
+		for (; bits != 0; bits &= bits - 1)
+		{
+			double value = block[simd::countTrailingZeros(bits)];
+			++sparse.count;
+			sparse.sum += value;
+			sparse.min = value < sparse.min ? value : sparse.min;
+			sparse.max = value > sparse.max ? value : sparse.max;
+		}
+	}
+	aggregate_t result = dense.finish();
+	result.merge(sparse);
+	return result;
+}
+
+void simd::filterNumbers(const double *numbers, size_t size, const uint64_t *mask, size_t first_word, size_t last_word, double low, double high, uint64_t *selection)
+{
+	for (size_t word = first_word; word < last_word; ++word)
+	{
+		uint64_t bits = mask[word];
+		const double *block = numbers + word * WORD_ROWS;
+		if (bits == 0)
+		{
+			selection[word] = 0;
+			continue;
+		}
+		if ((word + 1) * WORD_ROWS <= size)
+		{
+			// Rows without a number hold NaN, which never compares in range, but the mask is applied regardless.
+			selection[word] = filterDense(block, low, high) & bits;
+			continue;
+		}
+		uint64_t matches = 0;
+		for (; bits != 0; bits &= bits - 1)
+		{
+			unsigned int offset = simd::countTrailingZeros(bits);
+			matches |= static_cast<uint64_t>(block[offset] >= low && block[offset] <= high) << offset;
+		}
+		selection[word] = matches;
+	}
+}
@@ -0,0 +1,86 @@
+/**
+ * @file    ColumnKernels.hpp
+ * @author  James Horner
+ * @brief   This file contains the vectorised aggregate and filter kernels run over the columns of a ColumnarSheet.
+ * @details The kernels walk a column 64 rows at a time, one word of its presence bitmap. Words where every row holds
+ *          a number are processed with AVX2, SSE2, or NEON without looking at the bitmap, empty words are skipped, and
+ *          the remaining words visit each set bit. As with the XML scanner, the instruction set is chosen when
+ *          compiling, so building with the NATIVE option is required to use AVX2.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef ColumnKernels_HPP
+#define ColumnKernels_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace excel_parser
+{
+    /**
+     * @brief   Structural representation of the aggregates of the numbers in a selection of a column.
+     */
+    struct aggregate_t
+    {
+        /// Number of numbers in the selection.
+        size_t count = 0;
+        /// Sum of the numbers.
+        double sum = 0;
+        /// Smallest number, infinity if the selection is empty.
+        double min = std::numeric_limits<double>::infinity();
+        /// Largest number, negative infinity if the selection is empty.
+        double max = -std::numeric_limits<double>::infinity();
+
+        /**
+         * @brief   Method mean computes the arithmetic mean of the numbers.
+         * @return  double mean of the numbers, NaN if the selection is empty.
+         */
+        double mean() const { return count == 0 ? std::numeric_limits<double>::quiet_NaN() : sum / static_cast<double>(count); }
+
+        /**
+         * @brief       Method merge combines the aggregates of another, disjoint selection into these.
+         * @param other aggregates to be combined.
+         */
+        void merge(const aggregate_t &other)
+        {
+            count += other.count;
+            sum += other.sum;
+            min = other.min < min ? other.min : min;
+            max = other.max > max ? other.max : max;
+        }
+    };
+
+    namespace simd
+    {
+        /**
+         * @brief               Function aggregateNumbers aggregates the numbers of a run of words of a column.
+         * @param numbers       array of the numbers of the column.
+         * @param size          number of elements in numbers.
+         * @param mask          bitmap of the rows holding a number, with at least last_word words.
+         * @param selection     bitmap of the rows to be included, with at least last_word words, or nullptr to
+         *                      include every row.
+         * @param first_word    index of the first word of the bitmap to be aggregated.
+         * @param last_word     index one past the last word of the bitmap to be aggregated.
+         * @return              aggregate_t aggregates of the numbers of the rows set in both bitmaps.
+         */
+        aggregate_t aggregateNumbers(const double *numbers, size_t size, const uint64_t *mask, const uint64_t *selection, size_t first_word, size_t last_word);
+
+        /**
+         * @brief               Function filterNumbers finds the rows of a run of words of a column holding a number in
+         *                      a closed range.
+         * @param numbers       array of the numbers of the column.
+         * @param size          number of elements in numbers.
+         * @param mask          bitmap of the rows holding a number, with at least last_word words.
+         * @param first_word    index of the first word of the bitmap to be filtered.
+         * @param last_word     index one past the last word of the bitmap to be filtered.
+         * @param low           lowest value to be included.
+         * @param high          highest value to be included.
+         * @param selection     bitmap with at least last_word words, whose words in the run are set to the matching rows.
+         */
+        void filterNumbers(const double *numbers, size_t size, const uint64_t *mask, size_t first_word, size_t last_word, double low, double high, uint64_t *selection);
+    }
+}
+
+#endif /* ColumnKernels_HPP */
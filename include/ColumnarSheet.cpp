@@ -0,0 +1,203 @@
+#include "ColumnarSheet.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+
+#include "SimdScan.hpp"
+#include "ThreadPool.hpp"
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+ColumnarSheet ColumnarSheet::fromSheet(const sheet &s)
+{
+	ColumnarSheet columnar;
+	for (auto &r : s)
+	{
+		columnar.appendRow(r.first, r.second);
+	}
+	// Every column holding cells has a slot for every row once the sheet is complete, so the arrays can be handed
+	// out whole. The columns between them hold no cells and are left without any slots.
+	for (auto &column : columnar.columns)
+	{
+		if (column.size() > 0)
+		{
+			column.resize(columnar.row_count);
+		}
+	}
+	return columnar;
+}
+
+void ColumnarSheet::appendRow(int row_id, const row &r)
+{
+	if (row_count == 0)
+	{
+		first_row = row_id;
+	}
+	else if (row_id < first_row + static_cast<int>(row_count))
+	{
+		throw std::runtime_error("[Excel Parser] (ERROR) Row " + std::to_string(row_id) + " appended to columnar sheet out of order.");
+	}
+	size_t offset = static_cast<size_t>(row_id - first_row);
+	row_count = offset + 1;
+	setBit(row_mask, offset);
+
+	for (auto &c : r)
+	{
+		// Only numbers and shared strings have a column of values, so INLINE_STRING and ERROR cells read as empty.
+		if (c.second.type != NUMBER && c.second.type != STRING)
+		{
+			continue;
+		}
+		int column_index = c.first;
+		if (static_cast<size_t>(column_index) >= columns.size())
+		{
+			columns.resize(column_index + 1);
+		}
+		Column &column = columns[column_index];
+		column.resize(row_count);
+
+		if (c.second.type == NUMBER)
+		{
+			column.numbers[offset] = c.second.getNumber();
+			setBit(column.number_mask, offset);
+		}
+		else
+		{
+			column.string_indices[offset] = c.second.getStringIndex();
+			setBit(column.string_mask, offset);
+		}
+	}
+}
+
+const ColumnarSheet::Column &ColumnarSheet::getColumn(size_t column_index) const
+{
+	static const Column empty_column;
+	return column_index < columns.size() ? columns[column_index] : empty_column;
+}
+
+const ColumnarSheet::Column &ColumnarSheet::getColumn(std::string_view column_name) const
+{
+	int column_index = columnIndex(column_name);
+	return getColumn(column_index < 0 ? columns.size() : static_cast<size_t>(column_index));
+}
+
+std::vector<int> ColumnarSheet::getRows(const std::vector<uint64_t> &selection) const
+{
+	std::vector<int> rows;
+	for (size_t word = 0; word < selection.size(); ++word)
+	{
+		for (uint64_t bits = selection[word]; bits != 0; bits &= bits - 1)
+		{
+			rows.push_back(first_row + static_cast<int>(word * 64 + simd::countTrailingZeros(bits)));
+		}
+	}
+	return rows;
+}
+
+size_t ColumnarSheet::getMemoryUsage() const
+{
+	size_t bytes = sizeof(ColumnarSheet) + row_mask.capacity() * sizeof(uint64_t) + columns.capacity() * sizeof(Column);
+	for (auto &column : columns)
+	{
+		bytes += column.numbers.capacity() * sizeof(double) + column.string_indices.capacity() * sizeof(uint32_t) +
+				 (column.number_mask.capacity() + column.string_mask.capacity()) * sizeof(uint64_t);
+	}
+	return bytes;
+}
+
+std::vector<uint64_t> ColumnarSheet::Column::filter(double low, double high, unsigned int threads) const
+{
+	// Each block writes only its own words of the selection.
+	std::vector<uint64_t> selection(number_mask.size(), 0);
+	forEachBlock(number_mask.size(), threads, [this, low, high, &selection](size_t first_word, size_t last_word)
+				 { simd::filterNumbers(numbers.data(), numbers.size(), number_mask.data(), first_word, last_word, low, high, selection.data()); });
+	return selection;
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+aggregate_t ColumnarSheet::Column::aggregateWords(const uint64_t *selection, size_t words, unsigned int threads) const
+{
+	// The blocks are merged in row order so the rounding of the sum does not depend on which block finishes first.
+	std::mutex blocks_mutex;
+	std::map<size_t, aggregate_t> blocks;
+	forEachBlock(words, threads, [this, selection, &blocks, &blocks_mutex](size_t first_word, size_t last_word)
+				 {
+					 aggregate_t block = simd::aggregateNumbers(numbers.data(), numbers.size(), number_mask.data(), selection, first_word, last_word);
+					 std::lock_guard<std::mutex> lock(blocks_mutex);
+					 blocks.emplace(first_word, block); });
+	aggregate_t result;
+	for (auto &word_block : blocks)
+	{
+		result.merge(word_block.second);
+	}
+	return result;
+}
+
+void ColumnarSheet::forEachBlock(size_t words, unsigned int threads, const std::function<void(size_t first_word, size_t last_word)> &process)
+{
+	// Below 64K rows a block is faster on one thread than the cost of handing it to another.
+	const size_t minimum_block_words = 1024;
+	threads = threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+	size_t blocks = std::min<size_t>(threads, std::max<size_t>(1, words / minimum_block_words));
+	if (blocks <= 1)
+	{
+		process(0, words);
+		return;
+	}
+
+	// The workers are shared by every call rather than started and joined each time, and the calling thread takes
+	// the last block itself so a call never waits for a worker to become free before making progress.
+	ThreadPool &pool = blockPool();
+	std::vector<std::future<void>> futures;
+	size_t block_words = (words + blocks - 1) / blocks;
+	size_t first_word = 0;
+	for (; first_word + block_words < words; first_word += block_words)
+	{
+		size_t last_word = first_word + block_words;
+		futures.push_back(pool.submit([&process, first_word, last_word]()
+									  { process(first_word, last_word); }));
+	}
+	process(first_word, words);
+	for (auto &future : futures)
+	{
+		future.get();
+	}
+}
+
+ThreadPool &ColumnarSheet::blockPool()
+{
+	static ThreadPool pool(0);
+	return pool;
+}
+
+void ColumnarSheet::Column::resize(size_t slots)
+{
+	if (numbers.size() < slots)
+	{
+		numbers.resize(slots, std::nan(""));
+		string_indices.resize(slots, 0);
+	}
+	size_t words = (slots + 63) >> 6;
+	if (number_mask.size() < words)
+	{
+		number_mask.resize(words, 0);
+		string_mask.resize(words, 0);
+	}
+}
+
+void ColumnarSheet::setBit(std::vector<uint64_t> &mask, size_t offset)
+{
+	if ((offset >> 6) >= mask.size())
+	{
+		mask.resize((offset >> 6) + 1, 0);
+	}
+	mask[offset >> 6] |= uint64_t(1) << (offset & 63);
+}
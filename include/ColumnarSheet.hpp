@@ -0,0 +1,273 @@
+/**
+ * @file    ColumnarSheet.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the ColumnarSheet, a dense column oriented view of an Excel sheet.
+ * @details The ColumnarSheet stores each column of a sheet as contiguous typed arrays indexed by row, so that scans
+ *          over a column read sequential memory instead of walking the nodes of a sheet's maps.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef ColumnarSheet_HPP
+#define ColumnarSheet_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CellReference.hpp"
+#include "ColumnKernels.hpp"
+#include "ExcelTypes.hpp"
+
+namespace excel_parser
+{
+    class ThreadPool;
+
+    /**
+     * @brief   Class ColumnarSheet is a dense, column oriented representation of the cells of a sheet.
+     * @details Rows are addressed by their offset from the first row of the sheet. Every column holds one slot per
+     *          row for numbers and one for shared string indices, along with bitmaps recording which slots are
+     *          present, and the sheet holds a bitmap recording which rows are present.
+     */
+    class ColumnarSheet
+    {
+    public:
+        /**
+         * @brief   Class Column holds the typed arrays for a single column of a ColumnarSheet.
+         */
+        class Column
+        {
+        public:
+            /**
+             * @brief   Method size retrieves the number of row slots held by the column.
+             * @return  size_t number of row slots, which is 0 for a column without cells and otherwise the row count
+             *          of the sheet for sheets built by fromSheet, and may be less for sheets built with appendRow.
+             */
+            size_t size() const { return numbers.size(); }
+
+            /**
+             * @brief   Method getNumbers retrieves the contiguous array of numeric values of the column.
+             * @return  const double* array of size() values, NaN where the cell is not a NUMBER.
+             */
+            const double *getNumbers() const { return numbers.data(); }
+
+            /**
+             * @brief   Method getStringIndices retrieves the contiguous array of shared string indices of the column.
+             * @return  const uint32_t* array of size() indices, 0 where the cell is not a STRING.
+             */
+            const uint32_t *getStringIndices() const { return string_indices.data(); }
+
+            /**
+             * @brief   Method getNumberMask retrieves the bitmap of the row slots holding a NUMBER.
+             * @return  const std::vector<uint64_t>& bitmap with the slot at offset i in bit i % 64 of word i / 64.
+             */
+            const std::vector<uint64_t> &getNumberMask() const { return number_mask; }
+
+            /**
+             * @brief   Method getStringMask retrieves the bitmap of the row slots holding a STRING.
+             * @return  const std::vector<uint64_t>& bitmap with the slot at offset i in bit i % 64 of word i / 64.
+             */
+            const std::vector<uint64_t> &getStringMask() const { return string_mask; }
+
+            /**
+             * @brief           Method isNumber checks whether the cell at a row offset holds a NUMBER.
+             * @param offset    offset of the row from the first row of the sheet.
+             * @return          true if the cell is present and a NUMBER.
+             */
+            bool isNumber(size_t offset) const { return testBit(number_mask, offset); }
+
+            /**
+             * @brief           Method isString checks whether the cell at a row offset holds a STRING.
+             * @param offset    offset of the row from the first row of the sheet.
+             * @return          true if the cell is present and a STRING.
+             */
+            bool isString(size_t offset) const { return testBit(string_mask, offset); }
+
+            /**
+             * @brief           Method aggregate computes the count, sum, minimum, and maximum of the numbers in the column.
+             * @param threads   number of threads the row blocks of the column are split across, 0 uses the number
+             *                  of hardware threads.
+             * @return          aggregate_t aggregates of every NUMBER cell.
+             */
+            aggregate_t aggregate(unsigned int threads = 1) const { return aggregateWords(nullptr, number_mask.size(), threads); }
+
+            /**
+             * @brief           Method aggregate computes the count, sum, minimum, and maximum of a selection of the
+             *                  numbers in the column.
+             * @param selection bitmap of the row slots to be included, such as one returned by filter.
+             * @param threads   number of threads the row blocks of the column are split across, 0 uses the number
+             *                  of hardware threads.
+             * @return          aggregate_t aggregates of the selected NUMBER cells.
+             */
+            aggregate_t aggregate(const std::vector<uint64_t> &selection, unsigned int threads = 1) const
+            {
+                return aggregateWords(selection.data(), std::min(number_mask.size(), selection.size()), threads);
+            }
+
+            /**
+             * @brief           Method filter finds the row slots of the column holding a number in a closed range.
+             * @param low       lowest value to be included.
+             * @param high      highest value to be included.
+             * @param threads   number of threads the row blocks of the column are split across, 0 uses the number
+             *                  of hardware threads.
+             * @return          std::vector<uint64_t> bitmap of the matching row slots, which can be passed to
+             *                  aggregate, combined with the selections of other columns, or turned into row numbers
+             *                  with ColumnarSheet::getRows.
+             */
+            std::vector<uint64_t> filter(double low, double high, unsigned int threads = 1) const;
+
+        private:
+            friend class ColumnarSheet;
+
+            /**
+             * @brief           Method resize grows the arrays of the column to hold a number of row slots.
+             * @param slots     number of row slots required.
+             */
+            void resize(size_t slots);
+
+            /**
+             * @brief           Method aggregateWords aggregates the numbers of the column in parallel row blocks.
+             * @param selection bitmap of the row slots to be included, or nullptr to include every slot.
+             * @param words     number of words of the bitmaps to be aggregated.
+             * @param threads   number of threads, 0 uses the number of hardware threads.
+             * @return          aggregate_t aggregates of the included NUMBER cells.
+             */
+            aggregate_t aggregateWords(const uint64_t *selection, size_t words, unsigned int threads) const;
+
+            /// Numeric value of each row slot.
+            std::vector<double> numbers;
+            /// Shared string index of each row slot.
+            std::vector<uint32_t> string_indices;
+            /// Bitmap of the row slots holding a NUMBER.
+            std::vector<uint64_t> number_mask;
+            /// Bitmap of the row slots holding a STRING.
+            std::vector<uint64_t> string_mask;
+        };
+
+        /**
+         * @brief   Constructor for an empty ColumnarSheet.
+         */
+        ColumnarSheet() : first_row(0), row_count(0) {}
+
+        /**
+         * @brief       Method fromSheet builds a ColumnarSheet from the rows of a sheet.
+         * @param s     sheet object, as returned by ExcelParser::getSheet.
+         * @return      ColumnarSheet the columnar representation of the sheet.
+         */
+        static ColumnarSheet fromSheet(const sheet &s);
+
+        /**
+         * @brief           Method appendRow adds a row to the end of the sheet.
+         * @param row_id    number of the row, which must be greater than that of any row already appended.
+         * @param r         row object holding the cells of the row.
+         * @throws          std::runtime_error if the row is out of order.
+         * @note            Rows can be appended straight from ExcelParser::streamSheet, so a sheet can be loaded
+         *                  into columnar form without ever building its maps.
+         */
+        void appendRow(int row_id, const row &r);
+
+        /**
+         * @brief   Method getFirstRow retrieves the number of the first row of the sheet.
+         * @return  int number of the first row, which is the row at offset 0.
+         */
+        int getFirstRow() const { return first_row; }
+
+        /**
+         * @brief   Method getRowCount retrieves the number of row slots between the first and last rows.
+         * @return  size_t number of row slots.
+         */
+        size_t getRowCount() const { return row_count; }
+
+        /**
+         * @brief           Method hasRow checks whether a row was present in the sheet.
+         * @param row_id    number of the row.
+         * @return          true if the row was present.
+         */
+        bool hasRow(int row_id) const { return row_id >= first_row && testBit(row_mask, row_id - first_row); }
+
+        /**
+         * @brief   Method getColumnCount retrieves the number of columns in the sheet.
+         * @return  size_t one more than the index of the last column holding a cell.
+         */
+        size_t getColumnCount() const { return columns.size(); }
+
+        /**
+         * @brief               Method getColumn retrieves a column of the sheet by index.
+         * @param column_index  0 based index of the column.
+         * @return              const Column& the column, which is empty if no cell was ever stored in it.
+         */
+        const Column &getColumn(size_t column_index) const;
+
+        /**
+         * @brief               Method getColumn retrieves a column of the sheet by its letters.
+         * @param column_name   column letters (e.g. "A").
+         * @return              const Column& the column, which is empty if no cell was ever stored in it.
+         */
+        const Column &getColumn(std::string_view column_name) const;
+
+        /**
+         * @brief           Method getRows converts a bitmap of row slots into the numbers of the rows.
+         * @param selection bitmap of row slots, such as one returned by Column::filter.
+         * @return          std::vector<int> numbers of the selected rows in row order.
+         */
+        std::vector<int> getRows(const std::vector<uint64_t> &selection) const;
+
+        /**
+         * @brief   Method getMemoryUsage retrieves the number of bytes allocated for the columns and bitmaps.
+         * @return  size_t bytes allocated by the sheet.
+         */
+        size_t getMemoryUsage() const;
+
+    private:
+        /**
+         * @brief           Method forEachBlock splits a run of bitmap words into blocks and processes them in parallel.
+         * @param words     number of words.
+         * @param threads   number of threads, 0 uses the number of hardware threads.
+         * @param process   function called with the first and one past the last word of each block.
+         * @note            Blocks are at least 64K rows, so small columns are processed on the calling thread. Larger
+         *                  columns are split between the calling thread and the workers of blockPool, so threads
+         *                  beyond the number of hardware threads only make the blocks smaller.
+         */
+        static void forEachBlock(size_t words, unsigned int threads, const std::function<void(size_t first_word, size_t last_word)> &process);
+
+        /**
+         * @brief   Method blockPool retrieves the pool shared by every call to forEachBlock.
+         * @return  ThreadPool& pool with one worker per hardware thread, started on first use.
+         */
+        static ThreadPool &blockPool();
+
+        /**
+         * @brief           Function testBit checks a bit in a bitmap, treating bits past the end as clear.
+         * @param mask      bitmap to test.
+         * @param offset    index of the bit.
+         * @return          value of the bit.
+         */
+        static bool testBit(const std::vector<uint64_t> &mask, size_t offset)
+        {
+            return (offset >> 6) < mask.size() && (mask[offset >> 6] >> (offset & 63)) & 1;
+        }
+
+        /**
+         * @brief           Function setBit sets a bit in a bitmap, growing the bitmap as required.
+         * @param mask      bitmap to modify.
+         * @param offset    index of the bit.
+         */
+        static void setBit(std::vector<uint64_t> &mask, size_t offset);
+
+        /// Number of the row at offset 0.
+        int first_row;
+        /// Number of row slots between the first and last rows.
+        size_t row_count;
+        /// Bitmap of the row slots holding a row.
+        std::vector<uint64_t> row_mask;
+        /// Columns of the sheet indexed by column index.
+        std::vector<Column> columns;
+    };
+}
+
+#endif /* ColumnarSheet_HPP */
@@ -7,346 +7,1588 @@ using namespace excel_parser;
  ********************************************************************************************************************/
 ExcelParser *ExcelParser::instance = nullptr;
 
-std::mutex ExcelParser::io_mutex;
+std::shared_mutex ExcelParser::io_mutex;
 
-std::map<std::string, std::map<int, std::string>> ExcelParser::shared_strings_map;
+std::map<std::string, std::shared_ptr<const SharedStringTable>> ExcelParser::shared_strings_map;
 
-std::map<std::string, std::map<std::string, sheet>> ExcelParser::sheets_map;
+std::map<std::string, std::map<std::string, sheet_handle>> ExcelParser::sheets_map;
+
+std::map<std::string, std::map<std::string, std::shared_ptr<const ColumnarSheet>>> ExcelParser::columnar_sheets_map;
+
+std::map<std::string, std::map<std::string, std::map<std::pair<int, IndexType>, std::shared_ptr<const ColumnIndex>>>> ExcelParser::column_indexes_map;
+
+std::map<std::string, std::shared_ptr<WorkbookArchive>> ExcelParser::archives_map;
+
+std::map<std::string, open_options_t> ExcelParser::reload_options_map;
+
+std::map<std::string, workbook_signature_t> ExcelParser::signatures_map;
+
+SheetLru ExcelParser::sheet_lru;
+
+std::atomic<bool> ExcelParser::instrumented(false);
+
+std::atomic<uint64_t> ExcelParser::sheet_requests(0);
+
+std::atomic<uint64_t> ExcelParser::shared_string_requests(0);
+
+std::atomic<uint64_t> ExcelParser::lock_acquisitions(0);
+
+std::atomic<uint64_t> ExcelParser::lock_wait_nanoseconds(0);
+
+std::atomic<uint64_t> ExcelParser::failed_opens(0);
+
+std::atomic<uint64_t> ExcelParser::failed_reloads(0);
+
+std::atomic<uint64_t> ExcelParser::failed_sheets(0);
 
 /********************************************************************************************************************
  * PUBLIC METHODS ***************************************************************************************************
  ********************************************************************************************************************/
 ExcelParser *ExcelParser::getInstance()
 {
-	std::lock_guard<std::mutex> lock(io_mutex);
+	std::unique_lock<std::shared_mutex> lock = writeLock();
+
+	if (instance == nullptr)
+	{
+		instance = new ExcelParser();
+	}
+	return instance;
+}
+
+void ExcelParser::openExcelFile(const std::string &file_name)
+{
+	openExcelFile(file_name, open_options_t());
+}
+
+load_report_t ExcelParser::openExcelFile(const std::string &file_name, const open_options_t &options)
+{
+	try
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock = readLock();
+			if (sheets_map.find(file_name) != sheets_map.end())
+			{
+				return load_report_t();
+			}
+		}
+
+		// A file that has not changed since it was cached is read without touching libzip or the XML at all.
+		if (!options.cache_directory.empty() && !options.lazy && !options.resolve_strings && options.projection.readsWholeSheet())
+		{
+			auto start = std::chrono::steady_clock::now();
+			std::shared_ptr<const SharedStringTable> shared_strings;
+			std::map<std::string, sheet_handle> sheets;
+			workbook_signature_t signature;
+			if (WorkbookCache(options.cache_directory).load(file_name, shared_strings, sheets, signature))
+			{
+				load_report_t report;
+				report.from_cache = true;
+				report.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				storeWorkbook(file_name, std::move(shared_strings), std::move(sheets), options, true, std::move(signature));
+				return report;
+			}
+		}
+		return loadWorkbook(file_name, std::make_shared<WorkbookArchive>(file_name, options.memory_map), options);
+	}
+	catch (...)
+	{
+		++failed_opens;
+		throw;
+	}
+}
+
+load_report_t ExcelParser::openExcelBuffer(const std::string &file_name, std::vector<char> contents, open_options_t options)
+{
+	try
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock = readLock();
+			if (sheets_map.find(file_name) != sheets_map.end())
+			{
+				return load_report_t();
+			}
+		}
+		options.cache_directory.clear();
+		return loadWorkbook(file_name, std::make_shared<WorkbookArchive>(file_name, std::move(contents)), options);
+	}
+	catch (...)
+	{
+		++failed_opens;
+		throw;
+	}
+}
+
+open_result_t ExcelParser::tryOpenExcelFile(const std::string &file_name, const open_options_t &options) noexcept
+{
+	open_result_t result;
+	result.file_name = file_name;
+	try
+	{
+		result.report = openExcelFile(file_name, options);
+		result.success = true;
+	}
+	catch (std::exception &exception)
+	{
+		result.error = exception.what();
+	}
+	catch (...)
+	{
+		result.error = "[Excel Parser] (ERROR) Unknown error opening spreadsheet with name: " + file_name;
+	}
+	return result;
+}
+
+open_result_t ExcelParser::tryOpenExcelBuffer(const std::string &file_name, std::vector<char> contents, open_options_t options) noexcept
+{
+	open_result_t result;
+	result.file_name = file_name;
+	try
+	{
+		result.report = openExcelBuffer(file_name, std::move(contents), std::move(options));
+		result.success = true;
+	}
+	catch (std::exception &exception)
+	{
+		result.error = exception.what();
+	}
+	catch (...)
+	{
+		result.error = "[Excel Parser] (ERROR) Unknown error opening spreadsheet with name: " + file_name;
+	}
+	return result;
+}
+
+std::vector<batch_result_t> ExcelParser::openExcelFiles(const std::vector<std::string> &file_names, const open_options_t &options)
+{
+	// The pool is already spread across the files, so each file parses its sheets on the worker that opened it.
+	ThreadPool pool(options.threads);
+	open_options_t file_options = options;
+	file_options.threads = 1;
+
+	std::vector<std::future<open_result_t>> futures;
+	futures.reserve(file_names.size());
+	for (const std::string &file_name : file_names)
+	{
+		futures.push_back(pool.submit([file_name, &file_options]()
+									  { return tryOpenExcelFile(file_name, file_options); }));
+	}
+
+	std::vector<batch_result_t> results;
+	results.reserve(file_names.size());
+	for (std::future<open_result_t> &future : futures)
+	{
+		results.push_back(future.get());
+	}
+	return results;
+}
+
+void ExcelParser::closeExcelFile(const std::string &file_name)
+{
+	std::map<std::string, sheet_handle> sheets;
+	std::shared_ptr<const SharedStringTable> shared_strings;
+	std::map<std::string, std::shared_ptr<const ColumnarSheet>> columnar_sheets;
+	std::map<std::string, std::map<std::pair<int, IndexType>, std::shared_ptr<const ColumnIndex>>> column_indexes;
+	std::shared_ptr<WorkbookArchive> archive;
+	{
+		std::unique_lock<std::shared_mutex> lock = writeLock();
+		if (sheets_map.find(file_name) != sheets_map.end())
+		{
+			sheets = std::move(sheets_map.at(file_name));
+			sheets_map.erase(file_name);
+		}
+		if (shared_strings_map.find(file_name) != shared_strings_map.end())
+		{
+			shared_strings = std::move(shared_strings_map.at(file_name));
+			shared_strings_map.erase(file_name);
+		}
+		if (columnar_sheets_map.find(file_name) != columnar_sheets_map.end())
+		{
+			columnar_sheets = std::move(columnar_sheets_map.at(file_name));
+			columnar_sheets_map.erase(file_name);
+		}
+		if (column_indexes_map.find(file_name) != column_indexes_map.end())
+		{
+			column_indexes = std::move(column_indexes_map.at(file_name));
+			column_indexes_map.erase(file_name);
+		}
+		if (archives_map.find(file_name) != archives_map.end())
+		{
+			archive = std::move(archives_map.at(file_name));
+			archives_map.erase(file_name);
+		}
+		reload_options_map.erase(file_name);
+		signatures_map.erase(file_name);
+	}
+	sheet_lru.eraseFile(file_name);
+	// The data of the file is destroyed here, after the lock has been released.
+}
+
+load_report_t ExcelParser::reloadExcelFile(const std::string &file_name)
+{
+	// Reloading with default options would mix sheets read with and without the projection the file was opened with.
+	open_options_t options;
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		auto file_options = reload_options_map.find(file_name);
+		if (file_options != reload_options_map.end())
+		{
+			options = file_options->second;
+		}
+	}
+	return reloadExcelFile(file_name, options);
+}
+
+load_report_t ExcelParser::reloadExcelFile(const std::string &file_name, const open_options_t &options)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		if (sheets_map.find(file_name) == sheets_map.end())
+		{
+			lock.unlock();
+			return openExcelFile(file_name, options);
+		}
+	}
+	try
+	{
+		return reloadWorkbook(file_name, options);
+	}
+	catch (...)
+	{
+		++failed_reloads;
+		throw;
+	}
+}
+
+open_result_t ExcelParser::tryReloadExcelFile(const std::string &file_name) noexcept
+{
+	open_result_t result;
+	result.file_name = file_name;
+	try
+	{
+		result.report = reloadExcelFile(file_name);
+		result.success = true;
+	}
+	catch (std::exception &exception)
+	{
+		result.error = exception.what();
+	}
+	catch (...)
+	{
+		result.error = "[Excel Parser] (ERROR) Unknown error reloading spreadsheet with name: " + file_name;
+	}
+	return result;
+}
+
+open_result_t ExcelParser::tryReloadExcelFile(const std::string &file_name, const open_options_t &options) noexcept
+{
+	open_result_t result;
+	result.file_name = file_name;
+	try
+	{
+		result.report = reloadExcelFile(file_name, options);
+		result.success = true;
+	}
+	catch (std::exception &exception)
+	{
+		result.error = exception.what();
+	}
+	catch (...)
+	{
+		result.error = "[Excel Parser] (ERROR) Unknown error reloading spreadsheet with name: " + file_name;
+	}
+	return result;
+}
+
+sheet ExcelParser::getSheet(const std::string &file_name, const std::string &sheet_name)
+{
+	return *getSheetHandle(file_name, sheet_name);
+}
+
+sheet_handle ExcelParser::getSheetHandle(const std::string &file_name, const std::string &sheet_name)
+{
+	if (instrumented.load(std::memory_order_relaxed))
+	{
+		++sheet_requests;
+	}
+	std::shared_ptr<WorkbookArchive> archive;
+	{
+		// Each map is searched once and the iterators reused, as this is the path taken by every request.
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		auto file_sheets = sheets_map.find(file_name);
+		if (file_sheets == sheets_map.end())
+		{
+			std::string error_message = "[Excel Parser] (ERROR) Error finding spreadsheet with name: " + file_name;
+			throw std::runtime_error(error_message);
+		}
+		auto name_sheet = file_sheets->second.find(sheet_name);
+		if (name_sheet == file_sheets->second.end())
+		{
+			std::string error_message = "[Excel Parser] (ERROR) Error finding sheet with name \"" + sheet_name + "\" in file " + file_name;
+			throw std::runtime_error(error_message);
+		}
+		else if (name_sheet->second != nullptr)
+		{
+			sheet_lru.touch(file_name, sheet_name);
+			return name_sheet->second;
+		}
+		// Sheets that have not been read yet belong to lazily opened files or have been evicted.
+		auto file_archive = archives_map.find(file_name);
+		if (file_archive != archives_map.end())
+		{
+			archive = file_archive->second;
+		}
+	}
+	sheet_lru.recordMiss();
+	if (archive == nullptr)
+	{
+		archive = reopenArchive(file_name);
+	}
+	return loadSheet(file_name, sheet_name, archive);
+}
+
+ColumnarSheet ExcelParser::getColumnarSheet(const std::string &file_name, const std::string &sheet_name)
+{
+	return *getColumnarSheetHandle(file_name, sheet_name);
+}
+
+std::shared_ptr<const ColumnarSheet> ExcelParser::getColumnarSheetHandle(const std::string &file_name, const std::string &sheet_name)
+{
+	sheet_handle s;
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		if (columnar_sheets_map.find(file_name) != columnar_sheets_map.end() &&
+			columnar_sheets_map.at(file_name).find(sheet_name) != columnar_sheets_map.at(file_name).end())
+		{
+			return columnar_sheets_map.at(file_name).at(sheet_name);
+		}
+	}
+	s = getSheetHandle(file_name, sheet_name);
+
+	// Build the columnar representation without holding the lock, then store it unless the file was closed meanwhile.
+	std::shared_ptr<const ColumnarSheet> columnar = std::make_shared<const ColumnarSheet>(ColumnarSheet::fromSheet(*s));
+	std::unique_lock<std::shared_mutex> lock = writeLock();
+	if (sheets_map.find(file_name) != sheets_map.end() &&
+		sheets_map.at(file_name).find(sheet_name) != sheets_map.at(file_name).end() &&
+		sheets_map.at(file_name).at(sheet_name) == s)
+	{
+		columnar = columnar_sheets_map[file_name].emplace(sheet_name, columnar).first->second;
+		std::vector<SheetLru::sheet_key> evicted = chargeDerived(file_name, sheet_name);
+		lock.unlock();
+		evictSheets(evicted);
+	}
+	return columnar;
+}
+
+std::shared_ptr<const ColumnIndex> ExcelParser::getColumnIndex(const std::string &file_name, const std::string &sheet_name, const std::string &column_name, IndexType type)
+{
+	int column_index = columnIndex(column_name);
+	if (column_index < 0)
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error invalid column name \"" + column_name + "\" for index of sheet " + sheet_name;
+		throw std::runtime_error(error_message);
+	}
+	std::pair<int, IndexType> key(column_index, type);
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		auto file_column_indexes = column_indexes_map.find(file_name);
+		if (file_column_indexes != column_indexes_map.end())
+		{
+			auto sheet_column_indexes = file_column_indexes->second.find(sheet_name);
+			if (sheet_column_indexes != file_column_indexes->second.end())
+			{
+				auto column_index_handle = sheet_column_indexes->second.find(key);
+				if (column_index_handle != sheet_column_indexes->second.end())
+				{
+					return column_index_handle->second;
+				}
+			}
+		}
+	}
+	sheet_handle s = getSheetHandle(file_name, sheet_name);
+	std::shared_ptr<const SharedStringTable> shared_strings = getSharedStringTable(file_name);
+
+	// Build the index without holding the lock, then store it unless the sheet or its strings were replaced meanwhile.
+	std::shared_ptr<const ColumnIndex> index = std::make_shared<const ColumnIndex>(ColumnIndex::build(*s, shared_strings, column_index, type));
+	std::unique_lock<std::shared_mutex> lock = writeLock();
+	auto file_sheets = sheets_map.find(file_name);
+	auto file_shared_strings = shared_strings_map.find(file_name);
+	if (file_sheets != sheets_map.end() && file_shared_strings != shared_strings_map.end() && file_shared_strings->second == shared_strings)
+	{
+		auto name_sheet = file_sheets->second.find(sheet_name);
+		if (name_sheet != file_sheets->second.end() && name_sheet->second == s)
+		{
+			index = column_indexes_map[file_name][sheet_name].emplace(key, index).first->second;
+			std::vector<SheetLru::sheet_key> evicted = chargeDerived(file_name, sheet_name);
+			lock.unlock();
+			evictSheets(evicted);
+		}
+	}
+	return index;
+}
+
+aggregate_t ExcelParser::aggregateColumn(const std::string &file_name, const std::string &sheet_name, const std::string &column_name, unsigned int threads)
+{
+	return getColumnarSheetHandle(file_name, sheet_name)->getColumn(column_name).aggregate(threads);
+}
+
+aggregate_t ExcelParser::aggregateColumn(const std::string &file_name, const std::string &sheet_name, const std::string &column_name, double low, double high, unsigned int threads)
+{
+	std::shared_ptr<const ColumnarSheet> columnar = getColumnarSheetHandle(file_name, sheet_name);
+	const ColumnarSheet::Column &column = columnar->getColumn(column_name);
+	return column.aggregate(column.filter(low, high, threads), threads);
+}
+
+void ExcelParser::exportSheetToArrow(const std::string &file_name, const std::string &sheet_name, ArrowArray *array, ArrowSchema *schema)
+{
+	std::shared_ptr<const ColumnarSheet> columnar = getColumnarSheetHandle(file_name, sheet_name);
+	ArrowExporter::exportSheet(columnar, getSharedStringTable(file_name), sheet_name, array, schema);
+}
+
+std::string ExcelParser::getSharedString(const std::string &file_name, int shared_string_index)
+{
+	return std::string(getSharedStringView(file_name, shared_string_index));
+}
+
+std::string_view ExcelParser::getSharedStringView(const std::string &file_name, int shared_string_index)
+{
+	if (instrumented.load(std::memory_order_relaxed))
+	{
+		++shared_string_requests;
+	}
+	std::shared_ptr<const SharedStringTable> shared_strings = getSharedStringTable(file_name);
+	if (shared_string_index < 0 || !shared_strings->contains(shared_string_index))
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error finding shared string with index " + std::to_string(shared_string_index) + " in file " + file_name;
+		throw std::runtime_error(error_message);
+	}
+	return shared_strings->at(shared_string_index);
+}
+
+std::shared_ptr<const SharedStringTable> ExcelParser::getSharedStringTable(const std::string &file_name)
+{
+	std::shared_ptr<WorkbookArchive> archive;
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		auto file_strings = shared_strings_map.find(file_name);
+		if (file_strings != shared_strings_map.end())
+		{
+			return file_strings->second;
+		}
+		auto file_archive = archives_map.find(file_name);
+		if (file_archive == archives_map.end())
+		{
+			std::string error_message = "[Excel Parser] (ERROR) Error finding spreadsheet with name: " + file_name;
+			throw std::runtime_error(error_message);
+		}
+		archive = file_archive->second;
+	}
+	return loadSharedStrings(file_name, archive);
+}
+
+std::vector<std::string> ExcelParser::getSheetNames(const std::string &file_name)
+{
+	std::shared_lock<std::shared_mutex> lock = readLock();
+	if (sheets_map.find(file_name) == sheets_map.end())
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error finding spreadsheet with name: " + file_name;
+		throw std::runtime_error(error_message);
+	}
+	else
+	{
+		std::vector<std::string> sheet_names;
+		for (auto &s : sheets_map.at(file_name))
+		{
+			sheet_names.push_back(s.first);
+		}
+		return sheet_names;
+	}
+}
+
+void ExcelParser::setMemoryBudget(size_t bytes)
+{
+	evictSheets(sheet_lru.setBudget(bytes));
+}
+
+cache_stats_t ExcelParser::getCacheStats()
+{
+	return sheet_lru.getStats();
+}
+
+void ExcelParser::setInstrumentation(bool enabled)
+{
+	instrumented = enabled;
+}
+
+usage_stats_t ExcelParser::getUsageStats()
+{
+	usage_stats_t stats;
+	stats.sheet_requests = sheet_requests;
+	stats.shared_string_requests = shared_string_requests;
+	stats.lock_acquisitions = lock_acquisitions;
+	stats.lock_wait_seconds = lock_wait_nanoseconds / 1e9;
+	stats.failed_opens = failed_opens;
+	stats.failed_reloads = failed_reloads;
+	stats.failed_sheets = failed_sheets;
+	return stats;
+}
+
+void ExcelParser::resetUsageStats()
+{
+	sheet_requests = 0;
+	shared_string_requests = 0;
+	lock_acquisitions = 0;
+	lock_wait_nanoseconds = 0;
+	failed_opens = 0;
+	failed_reloads = 0;
+	failed_sheets = 0;
+}
+
+void ExcelParser::streamSheet(const std::string &file_name, const std::string &sheet_name, const row_callback &callback, projection_t projection)
+{
+	std::unique_ptr<SheetReader> cursor = openSheetReader(file_name, sheet_name, std::move(projection));
+	while (cursor->next())
+	{
+		callback(cursor->getRowId(), cursor->getRow());
+	}
+}
+
+std::unique_ptr<SheetReader> ExcelParser::openSheetReader(const std::string &file_name, const std::string &sheet_name, projection_t projection)
+{
+	std::unique_ptr<WorkbookArchive> archive = std::make_unique<WorkbookArchive>(file_name);
+	archive->setSheetParts(readWorkbook(archive->getBook(), archive->getBuffer()));
+	zip_file *file = openFileFromArchive(archive->getBook(), archive->getSheetPart(sheet_name));
+	return std::make_unique<SheetReader>(std::move(archive), file, std::move(projection));
+}
+
+/********************************************************************************************************************
+ * PROTECTED METHODS ************************************************************************************************
+ ********************************************************************************************************************/
+std::shared_lock<std::shared_mutex> ExcelParser::readLock()
+{
+	if (!instrumented.load(std::memory_order_relaxed))
+	{
+		return std::shared_lock<std::shared_mutex>(io_mutex);
+	}
+	auto start = std::chrono::steady_clock::now();
+	std::shared_lock<std::shared_mutex> lock(io_mutex);
+	lock_wait_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	++lock_acquisitions;
+	return lock;
+}
+
+std::unique_lock<std::shared_mutex> ExcelParser::writeLock()
+{
+	if (!instrumented.load(std::memory_order_relaxed))
+	{
+		return std::unique_lock<std::shared_mutex>(io_mutex);
+	}
+	auto start = std::chrono::steady_clock::now();
+	std::unique_lock<std::shared_mutex> lock(io_mutex);
+	lock_wait_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	++lock_acquisitions;
+	return lock;
+}
+
+void ExcelParser::addFileSize(zip *book, const std::string &file_name, uint64_t &compressed_bytes, uint64_t &uncompressed_bytes)
+{
+	struct zip_stat file_stat;
+	zip_stat_init(&file_stat);
+	if (zip_stat(book, file_name.c_str(), ZIP_FL_NODIR, &file_stat) == 0)
+	{
+		compressed_bytes += (file_stat.valid & ZIP_STAT_COMP_SIZE) ? file_stat.comp_size : 0;
+		uncompressed_bytes += (file_stat.valid & ZIP_STAT_SIZE) ? file_stat.size : 0;
+	}
+}
+
+load_report_t ExcelParser::loadWorkbook(const std::string &file_name, std::shared_ptr<WorkbookArchive> archive, const open_options_t &options)
+{
+	// Parse the file without holding the lock so readers of other files are never stalled.
+	load_report_t report;
+	auto start = std::chrono::steady_clock::now();
+	archive->setSheetParts(readWorkbook(archive->getBook(), archive->getBuffer()));
+	archive->setProjection(options.projection);
+	archive->setReadAhead(options.read_ahead);
+	workbook_signature_t signature = archive->readSignature();
+	addFileSize(archive->getBook(), "workbook.xml", report.compressed_bytes, report.uncompressed_bytes);
+
+	if (options.lazy)
+	{
+		// Only index the sheets, leaving a null handle for each until it is first requested. Sheets can only be
+		// resolved once the shared strings are known, so those are read up front when resolving.
+		std::map<std::string, sheet_handle> sheets;
+		for (auto &name_part : archive->getSheetParts())
+		{
+			sheets.emplace(name_part.first, nullptr);
+		}
+		std::shared_ptr<const SharedStringTable> shared_strings;
+		if (options.resolve_strings)
+		{
+			shared_strings = readSharedStrings(archive->getBook(), archive->getBuffer(), true);
+			report.shared_strings = shared_strings->size();
+		}
+		report.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::unique_lock<std::shared_mutex> lock = writeLock();
+		if (sheets_map.find(file_name) == sheets_map.end())
+		{
+			if (shared_strings != nullptr)
+			{
+				shared_strings_map[file_name] = std::move(shared_strings);
+			}
+			if (archive->canReopen())
+			{
+				reload_options_map[file_name] = options;
+			}
+			sheets_map[file_name] = std::move(sheets);
+			archives_map[file_name] = std::move(archive);
+			signatures_map[file_name] = std::move(signature);
+		}
+		return report;
+	}
+
+	auto shared_strings_start = std::chrono::steady_clock::now();
+	std::shared_ptr<const SharedStringTable> shared_strings = readSharedStrings(archive->getBook(), archive->getBuffer(), options.resolve_strings);
+	report.shared_strings_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - shared_strings_start).count();
+	report.shared_strings = shared_strings->size();
+	addFileSize(archive->getBook(), "sharedStrings.xml", report.compressed_bytes, report.uncompressed_bytes);
+
+	std::map<std::string, sheet_handle> sheets = parseSheets(*archive, options, report, options.resolve_strings ? shared_strings : nullptr);
+	report.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	report.estimated_bytes = shared_strings->getMemoryUsage() + archive->getBuffer().capacity();
+	for (auto &name_sheet : sheets)
+	{
+		report.estimated_bytes += sheetSize(*name_sheet.second);
+	}
+	for (auto &name_timing : report.sheet_timings)
+	{
+		report.compressed_bytes += name_timing.second.compressed_bytes;
+		report.uncompressed_bytes += name_timing.second.uncompressed_bytes;
+	}
+
+	// A file with a sheet that could not be parsed is not cached, or warm opens would never try the sheet again.
+	if (!options.cache_directory.empty() && options.projection.readsWholeSheet() && report.sheet_errors.empty())
+	{
+		WorkbookCache(options.cache_directory).store(file_name, *shared_strings, sheets, signature);
+	}
+	storeWorkbook(file_name, std::move(shared_strings), std::move(sheets), options, archive->canReopen(), std::move(signature));
+	return report;
+}
+
+load_report_t ExcelParser::reloadWorkbook(const std::string &file_name, const open_options_t &options)
+{
+	std::map<std::string, sheet_handle> old_sheets;
+	std::shared_ptr<const SharedStringTable> old_shared_strings;
+	workbook_signature_t old_signature;
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		auto file_sheets = sheets_map.find(file_name);
+		if (file_sheets == sheets_map.end())
+		{
+			lock.unlock();
+			return openExcelFile(file_name, options);
+		}
+		// The name of a file opened from a buffer is only a label, so there is nothing on disk to reload it from.
+		if (reload_options_map.find(file_name) == reload_options_map.end())
+		{
+			std::string error_message = "[Excel Parser] (ERROR) Error reloading spreadsheet with name " + file_name + ": it was opened from a buffer";
+			throw std::runtime_error(error_message);
+		}
+		old_sheets = file_sheets->second;
+		auto file_shared_strings = shared_strings_map.find(file_name);
+		if (file_shared_strings != shared_strings_map.end())
+		{
+			old_shared_strings = file_shared_strings->second;
+		}
+		auto file_signature = signatures_map.find(file_name);
+		if (file_signature != signatures_map.end())
+		{
+			old_signature = file_signature->second;
+		}
+	}
+
+	// Read the new version of the file without holding the lock, inflating only the parts that changed.
+	load_report_t report;
+	auto start = std::chrono::steady_clock::now();
+	std::shared_ptr<WorkbookArchive> archive = std::make_shared<WorkbookArchive>(file_name, options.memory_map);
+	archive->setSheetParts(readWorkbook(archive->getBook(), archive->getBuffer()));
+	archive->setProjection(options.projection);
+	archive->setReadAhead(options.read_ahead);
+	workbook_signature_t signature = archive->readSignature();
+	addFileSize(archive->getBook(), "workbook.xml", report.compressed_bytes, report.uncompressed_bytes);
+
+	std::shared_ptr<const SharedStringTable> shared_strings = old_shared_strings;
+	// Shared strings read without their views cannot resolve cells, so a reload that resolves them reads them again
+	// and treats them as changed, so that no sheet is kept with unresolved cells.
+	bool shared_strings_changed = !signature.shared_strings.matches(old_signature.shared_strings) ||
+								  (options.resolve_strings && old_shared_strings != nullptr && !old_shared_strings->hasViews());
+	if (shared_strings_changed)
+	{
+		shared_strings = nullptr;
+	}
+	// A file opened lazily may never have read its shared strings, and an eager version keeps no archive to read them
+	// from later, so they are read whenever they are missing rather than only when they have changed.
+	if (shared_strings == nullptr && (!options.lazy || options.resolve_strings))
+	{
+		auto shared_strings_start = std::chrono::steady_clock::now();
+		shared_strings = readSharedStrings(archive->getBook(), archive->getBuffer(), options.resolve_strings);
+		report.shared_strings_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - shared_strings_start).count();
+		addFileSize(archive->getBook(), "sharedStrings.xml", report.compressed_bytes, report.uncompressed_bytes);
+	}
+	report.shared_strings = shared_strings == nullptr ? 0 : shared_strings->size();
+
+	// Keep every sheet whose part is unchanged, including those not yet read or evicted, which are read from the new
+	// archive when they are next requested. Resolved sheets point at the text of the previous shared strings, so they
+	// are only kept if those are unchanged too.
+	std::map<std::string, sheet_handle> sheets;
+	std::map<std::string, std::string> changed_parts;
+	for (auto &name_part : archive->getSheetParts())
+	{
+		auto old_sheet = old_sheets.find(name_part.first);
+		auto old_part = old_signature.sheets.find(name_part.first);
+		if (old_sheet != old_sheets.end() && old_part != old_signature.sheets.end() &&
+			signature.sheets.at(name_part.first).matches(old_part->second) && !(options.resolve_strings && shared_strings_changed))
+		{
+			sheets.emplace(name_part.first, old_sheet->second);
+			report.reused_sheets += old_sheet->second != nullptr;
+		}
+		else if (options.lazy)
+		{
+			sheets.emplace(name_part.first, nullptr);
+		}
+		else
+		{
+			changed_parts.emplace(name_part.first, name_part.second);
+		}
+	}
+	if (!changed_parts.empty())
+	{
+		std::map<std::string, std::string> name_part_map = archive->getSheetParts();
+		archive->setSheetParts(std::move(changed_parts));
+		std::map<std::string, sheet_handle> changed_sheets = parseSheets(*archive, options, report, options.resolve_strings ? shared_strings : nullptr);
+		archive->setSheetParts(std::move(name_part_map));
+		for (auto &name_timing : report.sheet_timings)
+		{
+			report.compressed_bytes += name_timing.second.compressed_bytes;
+			report.uncompressed_bytes += name_timing.second.uncompressed_bytes;
+		}
+		sheets.insert(changed_sheets.begin(), changed_sheets.end());
+	}
+
+	std::map<std::string, size_t> sheet_sizes;
+	report.estimated_bytes = (shared_strings == nullptr ? 0 : shared_strings->getMemoryUsage()) + archive->getBuffer().capacity();
+	for (auto &name_sheet : sheets)
+	{
+		if (name_sheet.second != nullptr)
+		{
+			size_t size = sheetSize(*name_sheet.second);
+			report.estimated_bytes += size;
+			sheet_sizes.emplace(name_sheet.first, size);
+		}
+	}
+	report.total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Publish the new version unless the file was closed while it was being read, keeping only the columnar sheets
+	// and column indexes that were built from sheets that are kept. Indexes also hold the text of shared strings, so
+	// every index of the file is dropped when the shared strings change.
+	std::map<std::string, sheet_handle> published_sheets = sheets;
+	std::map<std::string, std::shared_ptr<const ColumnarSheet>> stale_columnar_sheets;
+	std::map<std::string, std::map<std::pair<int, IndexType>, std::shared_ptr<const ColumnIndex>>> stale_column_indexes;
+	std::vector<SheetLru::sheet_key> evicted;
+	{
+		std::unique_lock<std::shared_mutex> lock = writeLock();
+		auto file_sheets = sheets_map.find(file_name);
+		if (file_sheets == sheets_map.end())
+		{
+			return report;
+		}
+		std::swap(file_sheets->second, sheets);
+		if (shared_strings != nullptr)
+		{
+			shared_strings_map[file_name] = std::move(shared_strings);
+		}
+		else
+		{
+			shared_strings_map.erase(file_name);
+		}
+		auto file_columnar_sheets = columnar_sheets_map.find(file_name);
+		if (file_columnar_sheets != columnar_sheets_map.end())
+		{
+			for (auto it = file_columnar_sheets->second.begin(); it != file_columnar_sheets->second.end();)
+			{
+				auto new_sheet = published_sheets.find(it->first);
+				auto previous_sheet = sheets.find(it->first);
+				if (new_sheet == published_sheets.end() || previous_sheet == sheets.end() || new_sheet->second != previous_sheet->second)
+				{
+					stale_columnar_sheets.insert(file_columnar_sheets->second.extract(it++));
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+		auto file_column_indexes = column_indexes_map.find(file_name);
+		if (file_column_indexes != column_indexes_map.end())
+		{
+			for (auto it = file_column_indexes->second.begin(); it != file_column_indexes->second.end();)
+			{
+				auto new_sheet = published_sheets.find(it->first);
+				auto previous_sheet = sheets.find(it->first);
+				if (shared_strings_changed || new_sheet == published_sheets.end() || previous_sheet == sheets.end() || new_sheet->second != previous_sheet->second)
+				{
+					stale_column_indexes.insert(file_column_indexes->second.extract(it++));
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+		if (options.lazy)
+		{
+			archives_map[file_name] = archive;
+		}
+		else
+		{
+			archives_map.erase(file_name);
+		}
+		reload_options_map[file_name] = options;
+		signatures_map[file_name] = std::move(signature);
 
-	if (instance == nullptr)
+		// Charge the budget again for the sheets that lost some of what was built from them.
+		std::set<std::string> stale_sheets;
+		for (auto &name_columnar : stale_columnar_sheets)
+		{
+			stale_sheets.insert(name_columnar.first);
+		}
+		for (auto &name_indexes : stale_column_indexes)
+		{
+			stale_sheets.insert(name_indexes.first);
+		}
+		for (auto &sheet_name : stale_sheets)
+		{
+			std::vector<SheetLru::sheet_key> sheet_evicted = chargeDerived(file_name, sheet_name);
+			evicted.insert(evicted.end(), sheet_evicted.begin(), sheet_evicted.end());
+		}
+	}
+	evictSheets(evicted);
+
+	// The swap left the previous version in sheets, so forget the sheets it held that were replaced or removed and
+	// count the new ones against the memory budget.
+	for (auto &name_sheet : sheets)
 	{
-		instance = new ExcelParser();
+		auto new_sheet = published_sheets.find(name_sheet.first);
+		if (new_sheet == published_sheets.end() || new_sheet->second != name_sheet.second)
+		{
+			sheet_lru.erase(file_name, name_sheet.first);
+		}
 	}
-	return instance;
+	for (auto &name_size : sheet_sizes)
+	{
+		auto previous_sheet = sheets.find(name_size.first);
+		if (previous_sheet == sheets.end() || previous_sheet->second != published_sheets.at(name_size.first))
+		{
+			evictSheets(sheet_lru.insert(file_name, name_size.first, name_size.second));
+		}
+	}
+	// The replaced sheets are destroyed here, after the lock has been released.
+	return report;
 }
 
-void ExcelParser::openExcelFile(std::string file_name)
+void ExcelParser::storeWorkbook(const std::string &file_name, std::shared_ptr<const SharedStringTable> shared_strings, std::map<std::string, sheet_handle> sheets, const open_options_t &options, bool reloadable, workbook_signature_t signature)
 {
-	std::lock_guard<std::mutex> lock(io_mutex);
-	if (sheets_map.find(file_name) == sheets_map.end())
+	std::map<std::string, size_t> sheet_sizes;
+	if (reloadable)
 	{
-		int err = 0;
-		zip *book = zip_open(file_name.c_str(), 0, &err);
-		if (err)
+		for (auto &name_sheet : sheets)
 		{
-			std::string error_message = "[Excel Parser] (ERROR) Error opening spreadsheet archive: " + std::to_string(err);
-			throw std::runtime_error(error_message);
+			sheet_sizes.emplace(name_sheet.first, sheetSize(*name_sheet.second));
 		}
-
-		readSharedStrings(file_name, book);
-		parseSheetTrees(file_name, readWorkbookToTrees(book));
-
-		zip_close(book);
 	}
-}
 
-void ExcelParser::closeExcelFile(std::string file_name)
-{
-	std::lock_guard<std::mutex> lock(io_mutex);
-	if (sheets_map.find(file_name) != sheets_map.end())
 	{
-		sheets_map.erase(file_name);
+		std::unique_lock<std::shared_mutex> lock = writeLock();
+		if (sheets_map.find(file_name) != sheets_map.end())
+		{
+			return;
+		}
+		shared_strings_map[file_name] = std::move(shared_strings);
+		sheets_map[file_name] = std::move(sheets);
+		signatures_map[file_name] = std::move(signature);
+		if (reloadable)
+		{
+			reload_options_map[file_name] = options;
+		}
 	}
-	if (shared_strings_map.find(file_name) != shared_strings_map.end())
+
+	for (auto &name_size : sheet_sizes)
 	{
-		shared_strings_map.erase(file_name);
+		evictSheets(sheet_lru.insert(file_name, name_size.first, name_size.second));
 	}
 }
 
-sheet ExcelParser::getSheet(std::string file_name, std::string sheet_name)
+std::shared_ptr<WorkbookArchive> ExcelParser::reopenArchive(const std::string &file_name)
 {
-	std::lock_guard<std::mutex> lock(io_mutex);
-	if (sheets_map.find(file_name) == sheets_map.end())
+	open_options_t options;
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		if (reload_options_map.find(file_name) == reload_options_map.end())
+		{
+			std::string error_message = "[Excel Parser] (ERROR) Error reading evicted sheets of spreadsheet with name: " + file_name;
+			throw std::runtime_error(error_message);
+		}
+		options = reload_options_map.at(file_name);
+	}
+
+	std::shared_ptr<WorkbookArchive> archive = std::make_shared<WorkbookArchive>(file_name, options.memory_map);
+	archive->setSheetParts(readWorkbook(archive->getBook(), archive->getBuffer()));
+	archive->setProjection(options.projection);
+	archive->setReadAhead(options.read_ahead);
+	archive->readSignature();
+
+	// Keep whichever archive was stored first if several threads reopen the file at once.
+	std::unique_lock<std::shared_mutex> lock = writeLock();
+	if (reload_options_map.find(file_name) == reload_options_map.end())
 	{
 		std::string error_message = "[Excel Parser] (ERROR) Error finding spreadsheet with name: " + file_name;
 		throw std::runtime_error(error_message);
 	}
-	else if (sheets_map.at(file_name).find(sheet_name) == sheets_map.at(file_name).end())
+	return archives_map.emplace(file_name, archive).first->second;
+}
+
+void ExcelParser::evictSheets(const std::vector<SheetLru::sheet_key> &evicted)
+{
+	if (evicted.empty())
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error finding sheet with name \"" + sheet_name + "\" in file " + file_name;
-		throw std::runtime_error(error_message);
+		return;
 	}
-	else
+
+	// Move the evicted sheets out so they are destroyed after the lock has been released. The columnar sheet and
+	// indexes built from a sheet are released with it, or on their own when their entry of the budget is evicted.
+	const std::string derived_suffix = derivedKey(std::string());
+	std::vector<sheet_handle> released;
+	std::vector<std::shared_ptr<const ColumnarSheet>> released_columnar;
+	std::vector<std::map<std::pair<int, IndexType>, std::shared_ptr<const ColumnIndex>>> released_indexes;
+	std::unique_lock<std::shared_mutex> lock = writeLock();
+	for (auto &key : evicted)
 	{
-		return sheets_map.at(file_name).at(sheet_name);
+		std::string sheet_name = key.second;
+		if (sheet_name.size() > derived_suffix.size() && sheet_name.compare(sheet_name.size() - derived_suffix.size(), derived_suffix.size(), derived_suffix) == 0)
+		{
+			sheet_name.resize(sheet_name.size() - derived_suffix.size());
+		}
+		else
+		{
+			if (sheets_map.find(key.first) != sheets_map.end() && sheets_map.at(key.first).find(sheet_name) != sheets_map.at(key.first).end())
+			{
+				released.push_back(std::move(sheets_map.at(key.first).at(sheet_name)));
+				sheets_map.at(key.first).at(sheet_name) = nullptr;
+			}
+			sheet_lru.erase(key.first, derivedKey(sheet_name));
+		}
+		if (columnar_sheets_map.find(key.first) != columnar_sheets_map.end() && columnar_sheets_map.at(key.first).find(sheet_name) != columnar_sheets_map.at(key.first).end())
+		{
+			released_columnar.push_back(std::move(columnar_sheets_map.at(key.first).at(sheet_name)));
+			columnar_sheets_map.at(key.first).erase(sheet_name);
+		}
+		auto file_column_indexes = column_indexes_map.find(key.first);
+		if (file_column_indexes != column_indexes_map.end() && file_column_indexes->second.find(sheet_name) != file_column_indexes->second.end())
+		{
+			released_indexes.push_back(std::move(file_column_indexes->second.at(sheet_name)));
+			file_column_indexes->second.erase(sheet_name);
+		}
 	}
 }
 
-std::string ExcelParser::getSharedString(std::string file_name, int shared_string_index)
+std::string ExcelParser::derivedKey(const std::string &sheet_name)
+{
+	// Sheet names cannot hold '[', so the key never names a sheet.
+	return sheet_name + "[derived]";
+}
+
+std::vector<SheetLru::sheet_key> ExcelParser::chargeDerived(const std::string &file_name, const std::string &sheet_name)
 {
-	std::lock_guard<std::mutex> lock(io_mutex);
-	if (shared_strings_map.find(file_name) == shared_strings_map.end())
+	size_t bytes = 0;
+	auto file_columnar_sheets = columnar_sheets_map.find(file_name);
+	if (file_columnar_sheets != columnar_sheets_map.end())
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error finding spreadsheet with name: " + file_name;
-		throw std::runtime_error(error_message);
+		auto name_columnar = file_columnar_sheets->second.find(sheet_name);
+		if (name_columnar != file_columnar_sheets->second.end())
+		{
+			bytes += name_columnar->second->getMemoryUsage();
+		}
 	}
-	else if (shared_strings_map.at(file_name).find(shared_string_index) == shared_strings_map.at(file_name).end())
+	auto file_column_indexes = column_indexes_map.find(file_name);
+	if (file_column_indexes != column_indexes_map.end())
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error finding shared string with index " + std::to_string(shared_string_index) + " in file " + file_name;
-		throw std::runtime_error(error_message);
+		auto sheet_column_indexes = file_column_indexes->second.find(sheet_name);
+		if (sheet_column_indexes != file_column_indexes->second.end())
+		{
+			for (auto &key_index : sheet_column_indexes->second)
+			{
+				bytes += key_index.second->getMemoryUsage();
+			}
+		}
 	}
-	else
+	if (bytes == 0)
 	{
-		return shared_strings_map.at(file_name).at(shared_string_index);
+		sheet_lru.erase(file_name, derivedKey(sheet_name));
+		return std::vector<SheetLru::sheet_key>();
 	}
+	return sheet_lru.insert(file_name, derivedKey(sheet_name), bytes);
 }
 
-std::vector<std::string> ExcelParser::getSheetNames(std::string file_name)
+size_t ExcelParser::sheetSize(const sheet &s)
 {
-	std::lock_guard<std::mutex> lock(io_mutex);
-	if (sheets_map.find(file_name) == sheets_map.end())
+	// Sheets held in an arena are measured exactly by the bytes the arena handed out.
+	const SheetArena *arena = dynamic_cast<const SheetArena *>(s.get_allocator().resource());
+	if (arena != nullptr)
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error finding spreadsheet with name: " + file_name;
-		throw std::runtime_error(error_message);
+		return arena->getAllocatedBytes();
 	}
-	else
+
+	// Each map node holds its value along with three pointers and a colour in a separate allocation.
+	const size_t node_overhead = 4 * sizeof(void *);
+	size_t bytes = sizeof(sheet);
+	for (auto &row_cells : s)
 	{
-		std::vector<std::string> sheet_names;
-		for (auto &s : sheets_map.at(file_name))
-		{
-			sheet_names.push_back(s.first);
-		}
-		return sheet_names;
+		// The cells of each row are held in a single allocation.
+		bytes += node_overhead + sizeof(sheet::value_type) + row_cells.second.capacity() * sizeof(row::value_type);
 	}
+	return bytes;
 }
 
-/********************************************************************************************************************
- * PROTECTED METHODS ************************************************************************************************
- ********************************************************************************************************************/
-void ExcelParser::readSharedStrings(std::string file_name, zip *book)
+std::shared_ptr<const SharedStringTable> ExcelParser::readSharedStrings(zip *book, std::vector<char> &buffer, bool resolvable)
 {
-	int index = -1;
-	boost::property_tree::ptree strings_tree = readFileFromArchive(book, std::string("sharedStrings.xml"));
+	std::shared_ptr<SharedStringTable> shared_strings = std::make_shared<SharedStringTable>();
+	if (zip_name_locate(book, "sharedStrings.xml", ZIP_FL_NODIR) < 0)
+	{
+		// Workbooks without any text cells have no shared strings file.
+		return shared_strings;
+	}
+
 	try
 	{
-		boost::property_tree::ptree string_trees = strings_tree.get_child("sst");
-		for (auto &string_values : string_trees)
+		ZipEntrySource source(openFileFromArchive(book, "sharedStrings.xml"));
+		XmlStreamReader strings_reader(source, buffer);
+		std::string s;
+		bool in_string = false;
+		bool in_text = false;
+		int phonetic_depth = 0;
+		for (XmlEvent event = strings_reader.next(); event != END_DOCUMENT; event = strings_reader.next())
 		{
-			if (string_values.first.compare(XML_ATTR) != 0)
+			if (event == START_ELEMENT)
+			{
+				std::string_view name = strings_reader.name();
+				if (name == "si")
+				{
+					in_string = true;
+					s.clear();
+				}
+				else if (name == "rPh")
+				{
+					// Phonetic runs are hints for the text and not part of it.
+					++phonetic_depth;
+				}
+				else if (name == "t" && in_string && phonetic_depth == 0)
+				{
+					in_text = true;
+				}
+			}
+			else if (event == TEXT)
+			{
+				if (in_text)
+				{
+					s.append(strings_reader.text());
+				}
+			}
+			else
 			{
-				try
+				std::string_view name = strings_reader.name();
+				if (name == "t")
+				{
+					in_text = false;
+				}
+				else if (name == "rPh")
 				{
-					++index;
-					if (string_values.second.find("r") != string_values.second.not_found())
-					{
-						std::string s;
-						// boost::property_tree::ptree rows = string_values.second.get_child("si");
-						for (auto &r : string_values.second)
-						{
-							s = s + r.second.get_child("t").data();
-						}
-						shared_strings_map[file_name].emplace(std::pair<int, std::string>(index, s));
-					}
-					else
-					{
-						boost::property_tree::ptree string_tree = string_values.second.get_child("t");
-						shared_strings_map[file_name].emplace(std::pair<int, std::string>(index, string_tree.data()));
-					}
+					--phonetic_depth;
 				}
-				catch (boost::property_tree::ptree_error ptree_error)
+				else if (name == "si")
 				{
-					std::cout << "[Excel Parser] (ERROR) Error accessing the shared string at index " << index << " in the property tree: " << ptree_error.what() << std::endl;
+					in_string = false;
+					shared_strings->append(s);
 				}
 			}
 		}
 	}
-	catch (boost::property_tree::ptree_error ptree_error)
+	catch (const std::exception &exception)
 	{
-		std::cout << "[Excel Parser] (ERROR) Error accessing the shared strings property tree: " << ptree_error.what() << std::endl;
+		// A truncated table would leave the cells after the error pointing at strings that do not exist.
+		throw std::runtime_error("[Excel Parser] (ERROR) Error reading the shared strings at index " + std::to_string(shared_strings->size()) + ": " + exception.what());
 	}
+	shared_strings->finish();
+	if (resolvable)
+	{
+		shared_strings->buildViews();
+	}
+	return shared_strings;
 }
 
-std::map<std::string, boost::property_tree::ptree> ExcelParser::readWorkbookToTrees(zip *book)
+std::map<std::string, std::string> ExcelParser::readWorkbook(zip *book, std::vector<char> &buffer)
 {
-	boost::property_tree::ptree workbook_tree;
-	std::map<int, std::string> id_name_map;
-	std::map<std::string, boost::property_tree::ptree> name_sheet_tree_map;
+	std::map<std::string, std::string> name_part_map;
 	try
 	{
-		// Search for the file of given file_name and parse the XML workbook into a property tree.
-		workbook_tree = readFileFromArchive(book, "workbook.xml");
+		// Search for the file of given file_name and read the XML workbook into the buffer.
+		readFileFromArchive(book, "workbook.xml", buffer);
+		XmlStreamReader workbook_reader(buffer);
+		for (XmlEvent event = workbook_reader.next(); event != END_DOCUMENT; event = workbook_reader.next())
+		{
+			std::string_view sheet_name;
+			std::string_view relationship_id;
+			if (event == START_ELEMENT && workbook_reader.name() == "sheet" && workbook_reader.attribute("name", sheet_name) && workbook_reader.attribute("r:id", relationship_id))
+			{
+				int id = stoi(std::string(relationship_id.substr(3)));
+				name_part_map.emplace(std::pair<std::string, std::string>(sheet_name, "sheet" + std::to_string(id) + ".xml"));
+			}
+		}
 	}
-	catch (std::runtime_error runtime_error)
+	catch (std::exception &exception)
 	{
-		std::cout << "[Excel Parser] (ERROR) Reading the workbook: " << runtime_error.what() << std::endl;
-		exit(1);
+		throw std::runtime_error(std::string("[Excel Parser] (ERROR) Reading the workbook: ") + exception.what());
 	}
-	try
+	return name_part_map;
+}
+
+std::map<std::string, sheet_handle> ExcelParser::parseSheets(WorkbookArchive &archive, const open_options_t &options, load_report_t &report, std::shared_ptr<const SharedStringTable> shared_strings)
+{
+	const std::map<std::string, std::string> &name_part_map = archive.getSheetParts();
+	std::map<std::string, sheet_handle> sheets;
+	unsigned int threads = options.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : options.threads;
+
+	// Sheets large enough to be split are parsed by every thread in turn, so even a single sheet uses all of them.
+	std::set<std::string> chunked_sheets;
+	if (threads > 1 && options.chunk_bytes > 0)
+	{
+		for (auto &name_part : name_part_map)
+		{
+			uint64_t compressed_bytes = 0;
+			uint64_t uncompressed_bytes = 0;
+			addFileSize(archive.getBook(), name_part.second, compressed_bytes, uncompressed_bytes);
+			if (uncompressed_bytes >= options.chunk_bytes)
+			{
+				chunked_sheets.insert(name_part.first);
+			}
+		}
+	}
+	report.threads = chunked_sheets.empty() ? std::max(1u, std::min(threads, static_cast<unsigned int>(name_part_map.size()))) : threads;
+
+	// Create the timing entries up front so the tasks only ever write to their own entry.
+	for (auto &name_part : name_part_map)
+	{
+		report.sheet_timings[name_part.first] = sheet_timing_t();
+	}
+
+	if (report.threads == 1)
 	{
-		boost::property_tree::ptree sheets_tree = workbook_tree.get_child("workbook.sheets");
-		for (auto &sheets_values : sheets_tree)
+		for (std::map<std::string, std::string>::const_iterator it = name_part_map.begin(); it != name_part_map.end(); ++it)
 		{
-			boost::property_tree::ptree sheet_attributes = sheets_values.second.get_child(XML_ATTR);
-			std::string file_name = sheet_attributes.get_child("name").data();
-			int id = stoi(sheet_attributes.get_child("r:id").data().erase(0, 3));
-			id_name_map.emplace(std::pair<int, std::string>(id, file_name));
+			try
+			{
+				sheets.emplace(it->first, parseSheetFromArchive(archive.getBook(), it->second, report.sheet_timings.at(it->first), archive.getBuffer(), options.projection, options.read_ahead, shared_strings));
+			}
+			catch (std::exception &exception)
+			{
+				recordSheetError(report, it->first, exception);
+			}
 		}
+		return sheets;
 	}
-	catch (boost::property_tree::ptree_error ptree_error)
+
+	ThreadPool pool(report.threads);
+	std::map<std::string, std::future<sheet_handle>> futures;
+	for (auto &name_part : name_part_map)
 	{
-		std::cout << "[Excel Parser] (ERROR) Error accessing the workbook property tree: " << ptree_error.what() << std::endl;
+		if (chunked_sheets.count(name_part.first) > 0)
+		{
+			continue;
+		}
+		sheet_timing_t &timing = report.sheet_timings.at(name_part.first);
+		futures.emplace(name_part.first, pool.submit([&archive, &part_name = name_part.second, &timing, &options, &shared_strings]()
+													 {
+														 zip *task_book = archive.openBook();
+														 std::vector<char> buffer;
+														 try
+														 {
+															 sheet_handle s = parseSheetFromArchive(task_book, part_name, timing, buffer, options.projection, options.read_ahead, shared_strings);
+															 zip_close(task_book);
+															 return s;
+														 }
+														 catch (...)
+														 {
+															 zip_close(task_book);
+															 throw;
+														 } }));
 	}
 
-	for (std::map<int, std::string>::iterator it = id_name_map.begin(); it != id_name_map.end(); ++it)
+	// The chunks of large sheets are queued behind the smaller sheets, and the calling thread inflates each large
+	// sheet while the workers are busy.
+	for (const std::string &sheet_name : chunked_sheets)
+	{
+		try
+		{
+			sheets.emplace(sheet_name, parseSheetInChunks(archive.getBook(), name_part_map.at(sheet_name), report.sheet_timings.at(sheet_name), pool, options.projection, shared_strings));
+		}
+		catch (std::exception &exception)
+		{
+			recordSheetError(report, sheet_name, exception);
+		}
+	}
+	for (auto &name_future : futures)
 	{
-		std::string sheet_name = "sheet" + std::to_string(it->first) + ".xml";
-		boost::property_tree::ptree sheet_tree;
 		try
 		{
-			sheet_tree = readFileFromArchive(book, sheet_name);
-			name_sheet_tree_map.emplace(std::pair<std::string, boost::property_tree::ptree>(it->second, sheet_tree));
+			sheets.emplace(name_future.first, name_future.second.get());
 		}
-		catch (std::runtime_error runtime_error)
+		catch (std::exception &exception)
 		{
-			std::cout << "[Excel Parser] (ERROR) Reading " << it->second << " sheet: " << runtime_error.what() << std::endl;
+			recordSheetError(report, name_future.first, exception);
 		}
 	}
-	return name_sheet_tree_map;
+	return sheets;
 }
 
-void ExcelParser::parseSheetTrees(std::string file_name, std::map<std::string, boost::property_tree::ptree> name_sheet_tree_map)
+void ExcelParser::recordSheetError(load_report_t &report, const std::string &sheet_name, const std::exception &exception)
 {
-	for (std::map<std::string, boost::property_tree::ptree>::iterator it = name_sheet_tree_map.begin(); it != name_sheet_tree_map.end(); ++it)
+	report.sheet_errors[sheet_name] = exception.what();
+	++failed_sheets;
+}
+
+sheet_handle ExcelParser::parseSheetFromArchive(zip *book, const std::string &part_name, sheet_timing_t &timing, std::vector<char> &buffer, const projection_t &projection, bool read_ahead, std::shared_ptr<const SharedStringTable> shared_strings)
+{
+	auto start = std::chrono::steady_clock::now();
+	ZipEntrySource source(openFileFromArchive(book, part_name));
+	auto arena = std::make_shared<SheetArena>();
+	if (shared_strings != nullptr)
+	{
+		arena->retain(shared_strings);
+	}
+	double stalled_seconds = 0;
+	if (read_ahead)
+	{
+		// The parser only stalls when it catches up with the producer, so that is the time not spent parsing.
+		PrefetchSource prefetch(source);
+		XmlStreamReader sheet_reader(prefetch, buffer);
+		parseSheet(sheet_reader, projection, arena->getSheet(), shared_strings.get());
+		stalled_seconds = std::chrono::duration<double>(prefetch.getWaitTime()).count();
+	}
+	else
 	{
-		sheets_map[file_name].emplace(std::pair<std::string, sheet>(it->first, parseSheet(it->second)));
+		XmlStreamReader sheet_reader(source, buffer);
+		parseSheet(sheet_reader, projection, arena->getSheet(), shared_strings.get());
 	}
+	sheet_handle s = SheetArena::share(arena);
+
+	double inflate_seconds = std::chrono::duration<double>(source.getInflateTime()).count();
+	timing.inflate_seconds = inflate_seconds;
+	timing.parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - (read_ahead ? stalled_seconds : inflate_seconds);
+	timing.rows = s->size();
+	timing.cells = 0;
+	for (auto &row_cells : *s)
+	{
+		timing.cells += row_cells.second.size();
+	}
+	addFileSize(book, part_name, timing.compressed_bytes, timing.uncompressed_bytes);
+	return s;
 }
 
-sheet ExcelParser::parseSheet(boost::property_tree::ptree sheet_tree)
+sheet_handle ExcelParser::parseSheetInChunks(zip *book, const std::string &part_name, sheet_timing_t &timing, ThreadPool &pool, const projection_t &projection, std::shared_ptr<const SharedStringTable> shared_strings)
 {
-	sheet s = sheet();
-	boost::property_tree::ptree rows_tree = sheet_tree.get_child("worksheet.sheetData");
-	for (auto &row_tree : rows_tree)
+	auto start = std::chrono::steady_clock::now();
+	std::vector<char> document;
+	readFileFromArchive(book, part_name, document);
+	auto parse_start = std::chrono::steady_clock::now();
+
+	auto arena = std::make_shared<SheetArena>();
+	if (shared_strings != nullptr)
+	{
+		arena->retain(shared_strings);
+	}
+	sheet &s = arena->getSheet();
+	std::vector<std::string_view> chunks = splitSheetData(std::string_view(document.data(), document.size()), pool.size() * 4);
+	if (chunks.empty())
+	{
+		// Sheets whose rows cannot be located are parsed in one piece.
+		XmlStreamReader sheet_reader(document);
+		parseSheet(sheet_reader, projection, s, shared_strings.get());
+	}
+	else
 	{
-		if (row_tree.first.compare("row") == 0)
+		// Each chunk is parsed into its own child of the arena, as the arena is not thread safe.
+		std::vector<std::future<sheet>> futures;
+		for (std::string_view chunk : chunks)
+		{
+			SheetArena *chunk_arena = &arena->createChild();
+			const SharedStringTable *chunk_strings = shared_strings.get();
+			futures.push_back(pool.submit([chunk, chunk_arena, &projection, chunk_strings]()
+										  {
+											  MemorySource source(chunk.data(), chunk.size());
+											  XmlStreamReader chunk_reader(source);
+											  SheetReader rows(chunk_reader, projection, true);
+											  rows.setSharedStrings(chunk_strings);
+											  rows.setTextResource(chunk_arena);
+											  sheet partial(chunk_arena);
+											  while (rows.next())
+											  {
+												  partial.emplace_hint(partial.end(), rows.getRowId(), rows.getRow());
+											  }
+											  return partial; }));
+		}
+
+		// Every chunk must finish before the document is released, even if an earlier one failed. The chunks are in
+		// row order and their arenas compare equal to the arena of the sheet, so the nodes of each partial sheet are
+		// spliced onto the end of the sheet without copying.
+		std::exception_ptr error;
+		for (auto &future : futures)
 		{
-			int row_id;
-			row r = row();
 			try
 			{
-				row_id = stoi(getAttributes(row_tree.second).at("r"));
-				for (auto &column_tree : row_tree.second)
+				sheet partial = future.get();
+				while (!partial.empty())
 				{
-					if (column_tree.first.compare("c") == 0)
-					{
-						try
-						{
-							cell_t c;
-							c.value = column_tree.second.get_child("v").data();
-							xml_attributes cell_attributes = getAttributes(column_tree.second);
-							std::string cell_name = cell_attributes.at("r");
-							cell_name.erase(std::remove_if(cell_name.begin(), cell_name.end(), [](char c)
-														   { return !std::isalpha(c); }),
-											cell_name.end());
-							CellType cell_type;
-							try
-							{
-								std::string type_string = cell_attributes.at("t");
-								cell_type = STRING;
-							}
-							catch (std::out_of_range out_of_range)
-							{
-								cell_type = NUMBER;
-							}
-							c.type = cell_type;
-							r.emplace(std::pair<std::string, cell_t>(cell_name, c));
-						}
-						catch (boost::property_tree::ptree_error ptree_error)
-						{
-						}
-					}
+					s.insert(s.end(), partial.extract(partial.begin()));
 				}
-				s.emplace(std::pair<int, row>(row_id, r));
 			}
-			catch (std::runtime_error runtime_error)
+			catch (...)
+			{
+				error = error ? error : std::current_exception();
+			}
+		}
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+	}
+	sheet_handle handle = SheetArena::share(arena);
+
+	timing.inflate_seconds = std::chrono::duration<double>(parse_start - start).count();
+	timing.parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count();
+	timing.rows = handle->size();
+	timing.cells = 0;
+	for (auto &row_cells : *handle)
+	{
+		timing.cells += row_cells.second.size();
+	}
+	addFileSize(book, part_name, timing.compressed_bytes, timing.uncompressed_bytes);
+	return handle;
+}
+
+std::vector<std::string_view> ExcelParser::splitSheetData(std::string_view document, size_t chunks)
+{
+	size_t open = document.find("<sheetData");
+	size_t open_end = open == std::string_view::npos ? open : document.find('>', open);
+	size_t close = document.rfind("</sheetData>");
+	if (open_end == std::string_view::npos || document[open_end - 1] == '/' || close == std::string_view::npos || close < open_end)
+	{
+		return std::vector<std::string_view>();
+	}
+
+	// Finds the first row at or after an offset that has its number, as rows without one follow on from the row
+	// before them and so cannot start a chunk. Markup inside the sheet data is never escaped into text, so any
+	// "<row" is the start of a row element.
+	auto find_numbered_row = [document, close](size_t from)
+	{
+		for (size_t row = document.find("<row", from); row < close; row = document.find("<row", row + 4))
+		{
+			size_t tag_end = document.find('>', row);
+			if (tag_end > close || !std::isspace(static_cast<unsigned char>(document[row + 4])))
 			{
-				std::cout << "[Excel Parser] (ERROR) Error retrieving XML attributes in row: " << row_tree.second.data() << runtime_error.what() << std::endl;
+				continue;
 			}
-			catch (std::out_of_range out_of_range)
+			for (size_t r = document.find("r=", row + 4); r < tag_end; r = document.find("r=", r + 2))
 			{
-				std::cout << "[Excel Parser] (ERROR) Error parsing sheet could not value with key: " << out_of_range.what() << std::endl;
+				if (std::isspace(static_cast<unsigned char>(document[r - 1])))
+				{
+					return row;
+				}
 			}
 		}
+		return close;
+	};
+
+	std::vector<std::string_view> result;
+	size_t chunk_size = std::max<size_t>(1, (close - open_end) / std::max<size_t>(1, chunks));
+	for (size_t begin = open_end + 1; begin < close;)
+	{
+		size_t end = begin + chunk_size < close ? find_numbered_row(begin + chunk_size) : close;
+		result.push_back(document.substr(begin, end - begin));
+		begin = end;
 	}
-	return s;
+	return result;
 }
 
-boost::property_tree::ptree ExcelParser::readFileFromArchive(zip *book, std::string file_name)
+void ExcelParser::parseSheet(XmlStreamReader &sheet_reader, const projection_t &projection, sheet &s, const SharedStringTable *shared_strings)
 {
-	// Search for the file of given file_name
-	zip_uint64_t location = zip_name_locate(book, file_name.c_str(), ZIP_FL_NODIR);
-	if (location < 0)
+	// Rows arrive in order and are copied straight into the memory of the sheet, along with the text of their cells.
+	SheetReader cursor(sheet_reader, projection);
+	cursor.setSharedStrings(shared_strings);
+	cursor.setTextResource(s.get_allocator().resource());
+	while (cursor.next())
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error cannot find file in provided archive with file_name: " + file_name;
-		throw new std::runtime_error(error_message);
+		s.emplace_hint(s.end(), cursor.getRowId(), cursor.getRow());
+	}
+}
+
+void ExcelParser::readRows(XmlStreamReader &sheet_reader, const row_callback &callback, const projection_t &projection)
+{
+	SheetReader cursor(sheet_reader, projection);
+	while (cursor.next())
+	{
+		callback(cursor.getRowId(), cursor.getRow());
 	}
+}
 
-	// Get the information on the workbook file.
-	struct zip_stat workbook_stat;
-	zip_stat_init(&workbook_stat);
-	zip_stat_index(book, location, 0, &workbook_stat);
-	if (!(workbook_stat.valid & (ZIP_STAT_NAME | ZIP_STAT_SIZE)))
+sheet_handle ExcelParser::loadSheet(const std::string &file_name, const std::string &sheet_name, std::shared_ptr<WorkbookArchive> archive)
+{
+	// Holding the archive mutex serialises loads, so check whether another thread loaded the sheet while waiting.
+	std::lock_guard<std::mutex> archive_lock(archive->getMutex());
+	std::shared_ptr<const SharedStringTable> shared_strings;
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error retrieving metadata for file " + file_name + ": " + std::to_string(workbook_stat.valid);
-		throw new std::runtime_error(error_message);
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		if (archives_map.find(file_name) != archives_map.end() && archives_map.at(file_name) == archive &&
+			sheets_map.at(file_name).at(sheet_name) != nullptr)
+		{
+			return sheets_map.at(file_name).at(sheet_name);
+		}
+		// Archives reopened after an eviction read whatever is on disk now, which must still be the version whose
+		// shared strings and other sheets are held, or the string indices of the sheet would name the wrong text.
+		auto file_signature = signatures_map.find(file_name);
+		if (file_signature != signatures_map.end())
+		{
+			auto recorded = file_signature->second.sheets.find(sheet_name);
+			auto current = archive->getSignature().sheets.find(sheet_name);
+			if (recorded == file_signature->second.sheets.end() || current == archive->getSignature().sheets.end() ||
+				current->second.differs(recorded->second) || archive->getSignature().shared_strings.differs(file_signature->second.shared_strings))
+			{
+				std::string error_message = "[Excel Parser] (ERROR) Error reading sheet \"" + sheet_name + "\" of spreadsheet " + file_name + ": the file has changed since it was opened and must be reloaded";
+				throw std::runtime_error(error_message);
+			}
+		}
+		// Files opened with resolve_strings always have their strings loaded, and with their views built.
+		auto file_shared_strings = shared_strings_map.find(file_name);
+		if (file_shared_strings != shared_strings_map.end() && file_shared_strings->second->hasViews())
+		{
+			shared_strings = file_shared_strings->second;
+		}
 	}
 
-	// Alloc memory for its uncompressed contents
-	char *contents = new char[workbook_stat.size];
+	sheet_timing_t timing;
+	sheet_handle s = parseSheetFromArchive(archive->getBook(), archive->getSheetPart(sheet_name), timing, archive->getBuffer(), archive->getProjection(), archive->getReadAhead(), shared_strings);
 
-	// Read the compressed file
-	zip_file *f = zip_fopen_index(book, location, 0);
-	if (zip_fread(f, contents, workbook_stat.size) == -1)
+	// Store the sheet unless the file was closed while it was being read.
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error reading file " + file_name + ".";
-		throw new std::runtime_error(error_message);
+		std::unique_lock<std::shared_mutex> lock = writeLock();
+		if (archives_map.find(file_name) == archives_map.end() || archives_map.at(file_name) != archive)
+		{
+			return s;
+		}
+		sheets_map.at(file_name).at(sheet_name) = s;
 	}
+	evictSheets(sheet_lru.insert(file_name, sheet_name, sheetSize(*s)));
+	return s;
+}
 
-	// And close the file and archive
-	zip_fclose(f);
+std::shared_ptr<const SharedStringTable> ExcelParser::loadSharedStrings(const std::string &file_name, std::shared_ptr<WorkbookArchive> archive)
+{
+	std::lock_guard<std::mutex> archive_lock(archive->getMutex());
+	{
+		std::shared_lock<std::shared_mutex> lock = readLock();
+		if (shared_strings_map.find(file_name) != shared_strings_map.end())
+		{
+			return shared_strings_map.at(file_name);
+		}
+	}
 
-	// Parse the XML workbook into a property tree.
-	boost::property_tree::ptree tree;
-	std::stringstream stream = std::stringstream(std::string(contents, workbook_stat.size));
-	try
+	std::shared_ptr<const SharedStringTable> shared_strings = readSharedStrings(archive->getBook(), archive->getBuffer());
+
+	std::unique_lock<std::shared_mutex> lock = writeLock();
+	if (archives_map.find(file_name) != archives_map.end() && archives_map.at(file_name) == archive)
+	{
+		shared_strings_map[file_name] = shared_strings;
+	}
+	return shared_strings;
+}
+
+std::unique_ptr<SheetReader> ExcelParser::openSchemaReader(const std::string &file_name, const std::string &sheet_name, projection_t projection, bool resolve_strings, std::shared_ptr<const SharedStringTable> &shared_strings)
+{
+	std::unique_ptr<WorkbookArchive> archive = std::make_unique<WorkbookArchive>(file_name);
+	archive->setSheetParts(readWorkbook(archive->getBook(), archive->getBuffer()));
+	if (resolve_strings)
 	{
-		boost::property_tree::xml_parser::read_xml(stream, tree);
-		return tree;
+		// The strings are read from the same archive as the sheet, so they match even if the file has changed since
+		// it was opened.
+		shared_strings = readSharedStrings(archive->getBook(), archive->getBuffer(), true);
 	}
-	catch (boost::property_tree::xml_parser_error parse_error)
+	zip_file *file = openFileFromArchive(archive->getBook(), archive->getSheetPart(sheet_name));
+	std::unique_ptr<SheetReader> cursor = std::make_unique<SheetReader>(std::move(archive), file, std::move(projection));
+	cursor->setSharedStrings(shared_strings.get());
+	return cursor;
+}
+
+zip_file *ExcelParser::openFileFromArchive(zip *book, const std::string &file_name)
+{
+	// Search for the file of given file_name
+	zip_int64_t location = zip_name_locate(book, file_name.c_str(), ZIP_FL_NODIR);
+	if (location < 0)
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error parsing information in " + file_name + " at line " + std::to_string(parse_error.line()) + ": " + parse_error.what();
-		throw new std::runtime_error(error_message);
+		std::string error_message = "[Excel Parser] (ERROR) Error cannot find file in provided archive with file_name: " + file_name;
+		throw std::runtime_error(error_message);
 	}
-	catch (boost::property_tree::ptree_error ptree_error)
+
+	zip_file *f = zip_fopen_index(book, location, 0);
+	if (f == nullptr)
 	{
-		std::string error_message = "[Excel Parser] (ERROR) Error accessing " + file_name + " property tree: " + ptree_error.what();
-		throw new std::runtime_error(error_message);
+		std::string error_message = "[Excel Parser] (ERROR) Error opening file " + file_name + ".";
+		throw std::runtime_error(error_message);
 	}
+	return f;
 }
 
-xml_attributes ExcelParser::getAttributes(boost::property_tree::ptree tree)
+void ExcelParser::readFileFromArchive(zip *book, const std::string &file_name, std::vector<char> &contents)
 {
-	xml_attributes attributes_map;
-	try
+	// Search for the file of given file_name
+	zip_int64_t location = zip_name_locate(book, file_name.c_str(), ZIP_FL_NODIR);
+	if (location < 0)
 	{
-		boost::property_tree::ptree attributes_tree = tree.get_child(XML_ATTR);
-		for (auto &attribute_value : attributes_tree)
-		{
-			attributes_map.emplace(std::pair<std::string, std::string>(attribute_value.first, attribute_value.second.data()));
-		}
+		std::string error_message = "[Excel Parser] (ERROR) Error cannot find file in provided archive with file_name: " + file_name;
+		throw std::runtime_error(error_message);
+	}
+
+	// Get the information on the file.
+	struct zip_stat file_stat;
+	zip_stat_init(&file_stat);
+	zip_stat_index(book, location, 0, &file_stat);
+	if (!(file_stat.valid & ZIP_STAT_SIZE))
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error retrieving metadata for file " + file_name + ": " + std::to_string(file_stat.valid);
+		throw std::runtime_error(error_message);
 	}
-	catch (boost::property_tree::ptree_error ptree_error)
+
+	// Size the buffer for the uncompressed contents, which only allocates if it has never held a file this large.
+	contents.resize(file_stat.size);
+
+	// Read the compressed file straight into the buffer.
+	ZipEntrySource source(openFileFromArchive(book, file_name));
+	size_t bytes_read = 0;
+	while (bytes_read < contents.size())
 	{
-		std::string error_message = std::string("[Excel Parser] (ERROR) Error finding attributes of property tree: ") + ptree_error.what();
-		throw new std::runtime_error(error_message);
+		size_t chunk = source.read(contents.data() + bytes_read, contents.size() - bytes_read);
+		if (chunk == 0)
+		{
+			std::string error_message = "[Excel Parser] (ERROR) Error reading file " + file_name + ".";
+			throw std::runtime_error(error_message);
+		}
+		bytes_read += chunk;
 	}
-	return attributes_map;
 }
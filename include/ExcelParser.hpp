@@ -3,7 +3,7 @@
  * @author  James Horner
  * @brief   This file contains the declaration of the ExcelParser Singleton for accessing Excel files in C++.
  * @details The ExcelParser is responsible for opening, parsing, and storing the data from multiple Excel files. 
- *          The class is a singleton and includes mutexes to make it thread-safe.
+ *          The class is a singleton and includes a reader-writer mutex to make it thread-safe.
  * @date    2022-07-07
  *
  * @copyright Copyright (c) 2022
@@ -12,61 +12,171 @@
 #define ExcelParser_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <locale>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <sstream>
-
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/xml_parser.hpp>
+#include <vector>
 
 #include <zip.h>
 
-#define XML_ATTR "<xmlattr>"
+#include "ArrowExporter.hpp"
+#include "ColumnIndex.hpp"
+#include "ColumnarSheet.hpp"
+#include "ExcelTypes.hpp"
+#include "SharedStringTable.hpp"
+#include "SheetArena.hpp"
+#include "SheetLru.hpp"
+#include "SheetReader.hpp"
+#include "SheetSchema.hpp"
+#include "ThreadPool.hpp"
+#include "WorkbookArchive.hpp"
+#include "WorkbookCache.hpp"
+#include "XmlStreamReader.hpp"
 
 namespace excel_parser
 {
     /**
-     * @brief Enumeration of the different value types a cell can take.
+     * @brief Structural representation of the options controlling how an Excel file is opened.
      */
-    typedef enum
+    struct open_options_t
     {
-        NUMBER,
-        STRING
-    } CellType;
+        /// Number of threads used to inflate and parse the sheets of the file, 0 uses the number of hardware threads.
+        unsigned int threads = 1;
+        /// Whether to map the file into memory and have libzip read it through a buffer source, rather than through
+        /// buffered reads of the file.
+        bool memory_map = false;
+        /// Whether to only read the workbook when the file is opened, leaving the archive open and reading the shared
+        /// strings and each sheet the first time they are requested.
+        bool lazy = false;
+        /// Columns and rows of each sheet to be read, which is the whole of every sheet by default.
+        projection_t projection;
+        /// Directory of the on-disk cache of parsed files, the cache is not used if empty. A file is read from the
+        /// cache when it has not changed since it was cached, and cached after it is parsed otherwise. Files opened
+        /// lazily or with a projection that excludes any cells, and files with a sheet that could not be parsed, are
+        /// never cached.
+        std::string cache_directory;
+        /// Uncompressed size in bytes from which a sheet is inflated whole, split into chunks on row boundaries, and
+        /// the chunks parsed by all of the threads. Sheets are never split if 0 or if only one thread is used.
+        size_t chunk_bytes = 32 * 1024 * 1024;
+        /// Whether each sheet that is streamed is inflated on a separate thread ahead of the parser, so that inflating
+        /// and parsing the sheet overlap.
+        bool read_ahead = false;
+        /// Whether the STRING cells of each sheet point at the text of their shared string, so that cell_t::getText
+        /// reads the text without a call to getSharedString. The shared strings are read when the file is opened even
+        /// if it is opened lazily, and files are never read from the cache as it only holds string indices.
+        bool resolve_strings = false;
+    };
 
     /**
-     * @brief Structural representation of the type and contents of a cell.
+     * @brief Structural representation of the time taken to load a sheet of an Excel file.
      */
-    typedef struct
+    struct sheet_timing_t
     {
-        CellType type;
-        std::string value;
-    } cell_t;
+        /// Seconds spent inflating the sheet file from the archive.
+        double inflate_seconds = 0;
+        /// Seconds spent parsing the XML of the sheet, excluding inflating or waiting for it to be inflated ahead.
+        double parse_seconds = 0;
+        /// Number of rows read from the sheet.
+        size_t rows = 0;
+        /// Number of cells read from the sheet.
+        size_t cells = 0;
+        /// Compressed size of the sheet file in bytes.
+        uint64_t compressed_bytes = 0;
+        /// Uncompressed size of the sheet file in bytes.
+        uint64_t uncompressed_bytes = 0;
+    };
 
     /**
-     * @brief   Type definition representing a row of cells in a sheet.
-     * @note    The string entry denotes the Excel column index starting at 'A'.
+     * @brief Structural representation of the report produced when an Excel file is opened.
      */
-    using row = std::map<std::string, cell_t>;
+    struct load_report_t
+    {
+        /// Number of threads the sheets were parsed on.
+        unsigned int threads = 0;
+        /// Seconds spent opening the file in total.
+        double total_seconds = 0;
+        /// Whether the file was read from the on-disk cache rather than parsed.
+        bool from_cache = false;
+        /// Number of shared strings read from the file.
+        size_t shared_strings = 0;
+        /// Seconds spent inflating and parsing the shared strings.
+        double shared_strings_seconds = 0;
+        /// Compressed size in bytes of all the files read from the archive.
+        uint64_t compressed_bytes = 0;
+        /// Uncompressed size in bytes of all the files read from the archive.
+        uint64_t uncompressed_bytes = 0;
+        /// Estimated peak bytes held for the file, which are its sheets, shared strings, and decompression buffer.
+        size_t estimated_bytes = 0;
+        /// Number of sheets kept from the previously loaded version of the file by reloadExcelFile.
+        size_t reused_sheets = 0;
+        /// Map of the names of sheets that could not be parsed to the reason, which are left out of the file rather
+        /// than failing it.
+        std::map<std::string, std::string> sheet_errors;
+        /// Map of sheet names to the time taken to load each sheet.
+        std::map<std::string, sheet_timing_t> sheet_timings;
+    };
 
     /**
-     * @brief   Type definition representing a sheet in an Excel file.
+     * @brief Structural representation of the cumulative counters of calls to the ExcelParser.
      */
-    using sheet = std::map<int, row>;
+    struct usage_stats_t
+    {
+        /// Number of calls retrieving a sheet.
+        uint64_t sheet_requests = 0;
+        /// Number of calls retrieving a shared string.
+        uint64_t shared_string_requests = 0;
+        /// Number of times the reader-writer lock was acquired.
+        uint64_t lock_acquisitions = 0;
+        /// Seconds spent waiting to acquire the reader-writer lock.
+        double lock_wait_seconds = 0;
+        /// Number of files that could not be opened, which is counted even when the parser is not instrumented.
+        uint64_t failed_opens = 0;
+        /// Number of open files that could not be reloaded, which is counted even when the parser is not instrumented.
+        uint64_t failed_reloads = 0;
+        /// Number of sheets left out of the files they are in because they could not be parsed, which is counted even
+        /// when the parser is not instrumented.
+        uint64_t failed_sheets = 0;
+    };
 
     /**
-     * @brief   Type definition representing a map of XML attribute names to attribute values. 
+     * @brief Structural representation of the outcome of opening a file without throwing.
      */
-    using xml_attributes = std::map<std::string, std::string>;
+    struct open_result_t
+    {
+        /// Name of the file that was opened.
+        std::string file_name;
+        /// Whether the file was opened successfully.
+        bool success = false;
+        /// Message describing why the file could not be opened, empty on success.
+        std::string error;
+        /// Report of the time taken to load the file.
+        load_report_t report;
+    };
+
+    /**
+     * @brief Type definition representing the outcome of opening one file of a batch.
+     */
+    using batch_result_t = open_result_t;
 
     /**
      * @brief   Class ExcelParser is a Singleton that controls access to the contents of Excel files.
      * @details The singleton instance is responsible for opening, parsing, storing, and supplying
-     *          access to the Excel sheet contents. The class uses mutexes to ensure mutual exclusion 
-     *          between client threads.
+     *          access to the Excel sheet contents. The class uses a reader-writer mutex so that client threads
+     *          reading the stored data share access, while files are parsed outside the lock and only held
+     *          exclusively while their results are stored.
      */
     class ExcelParser
     {
@@ -74,67 +184,301 @@ namespace excel_parser
     private:
         /// Instance of the ExcelParser Singleton.
         static ExcelParser *instance;
-        /// Mutex to control access to the class.
-        static std::mutex io_mutex;
-        /// Map of file names to the map of shared strings in the file
-        static std::map<std::string, std::map<int, std::string>> shared_strings_map;
+        /// Reader-writer mutex to control access to the class.
+        static std::shared_mutex io_mutex;
+        /// Map of file names to the table of shared strings in the file
+        static std::map<std::string, std::shared_ptr<const SharedStringTable>> shared_strings_map;
         /// Map of file names to the map of sheets in the file
-        static std::map<std::string, std::map<std::string, sheet>> sheets_map;
+        static std::map<std::string, std::map<std::string, sheet_handle>> sheets_map;
+        /// Map of file names to the map of columnar sheets that have been built from the sheets in the file
+        static std::map<std::string, std::map<std::string, std::shared_ptr<const ColumnarSheet>>> columnar_sheets_map;
+        /// Map of file names to the map of sheet names to the indexes that have been built over columns of the sheet
+        static std::map<std::string, std::map<std::string, std::map<std::pair<int, IndexType>, std::shared_ptr<const ColumnIndex>>>> column_indexes_map;
+        /// Map of file names to the archives of files opened lazily, whose unread sheets have a null handle
+        static std::map<std::string, std::shared_ptr<WorkbookArchive>> archives_map;
+        /// Map of file names to the options they were opened with, for files whose sheets can be read again from disk,
+        /// which files opened from a buffer are not
+        static std::map<std::string, open_options_t> reload_options_map;
+        /// Map of file names to the signatures of the parts of the file that were loaded, used to find changed parts
+        static std::map<std::string, workbook_signature_t> signatures_map;
+        /// Order of use and estimated size of the sheets that can be evicted to stay within the memory budget
+        static SheetLru sheet_lru;
+        /// Whether the cumulative usage counters are being collected
+        static std::atomic<bool> instrumented;
+        /// Cumulative number of calls retrieving a sheet
+        static std::atomic<uint64_t> sheet_requests;
+        /// Cumulative number of calls retrieving a shared string
+        static std::atomic<uint64_t> shared_string_requests;
+        /// Cumulative number of times the reader-writer lock was acquired
+        static std::atomic<uint64_t> lock_acquisitions;
+        /// Cumulative nanoseconds spent waiting to acquire the reader-writer lock
+        static std::atomic<uint64_t> lock_wait_nanoseconds;
+        /// Counter of the files that could not be opened.
+        static std::atomic<uint64_t> failed_opens;
+        /// Counter of the open files that could not be reloaded.
+        static std::atomic<uint64_t> failed_reloads;
+        /// Counter of the sheets that could not be parsed.
+        static std::atomic<uint64_t> failed_sheets;
 
     protected:
+        /**
+         * @brief   Method readLock acquires the reader-writer lock for reading, timing the wait when instrumented.
+         * @return  std::shared_lock<std::shared_mutex> lock that is held until it is destroyed.
+         */
+        static std::shared_lock<std::shared_mutex> readLock();
+
+        /**
+         * @brief   Method writeLock acquires the reader-writer lock for writing, timing the wait when instrumented.
+         * @return  std::unique_lock<std::shared_mutex> lock that is held until it is destroyed.
+         */
+        static std::unique_lock<std::shared_mutex> writeLock();
+
+        /**
+         * @brief                       Method addFileSize adds the sizes of a file in the archive to a pair of totals.
+         * @param book                  pointer to the libzip handle for the Excel file.
+         * @param file_name             string name of the file in the archive.
+         * @param compressed_bytes      total the compressed size of the file is added to.
+         * @param uncompressed_bytes    total the uncompressed size of the file is added to.
+         */
+        static void addFileSize(zip *book, const std::string &file_name, uint64_t &compressed_bytes, uint64_t &uncompressed_bytes);
+
         /**
          * @brief   Constructor for the ExcelParser class only to be used by the getInstance method.
          */
         ExcelParser() {}
 
         /**
-         * @brief           Method readSharedStrings reads the shared strings file in the Excel archive then uses its
-         *                  content to populate the shared strings map.
-         * @param file_name string name of the Excel file that is being read.
+         * @brief           Method readSharedStrings streams the shared strings file out of the Excel archive into a
+         *                  table of shared strings.
          * @param book      pointer to the libzip handle for the Excel file.
+         * @param buffer    buffer reused for the window of the XML reader.
+         * @param resolvable whether to build the views of the strings that resolved cells point at.
+         * @return          std::shared_ptr<const SharedStringTable> table of shared strings, which is empty if the
+         *                  archive has no shared strings file.
+         * @throws          std::runtime_error if the shared strings file is malformed, which fails the whole file.
          */
-        static void readSharedStrings(std::string file_name, zip *book);
+        static std::shared_ptr<const SharedStringTable> readSharedStrings(zip *book, std::vector<char> &buffer, bool resolvable = false);
 
         /**
-         * @brief       Method readWorkbookToTrees reads the workbook file in the Excel archive then uses its contents
-         *              to read the sheets of the Excel file into boost property trees.
-         * @param book  pointer to the libzip handle for the Excel file.
-         * @return      std::map<std::string, boost::property_tree::ptree> map of sheet names to property trees of XML.
+         * @brief           Method readWorkbook reads the workbook file in the Excel archive then uses its contents to
+         *                  find the archive file that holds each sheet of the Excel file.
+         * @param book      pointer to the libzip handle for the Excel file.
+         * @param buffer    buffer the workbook file is inflated into and parsed in place.
+         * @return          std::map<std::string, std::string> map of sheet names to the names of the sheet files.
+         * @throws          std::runtime_error if the workbook file cannot be read.
+         */
+        static std::map<std::string, std::string> readWorkbook(zip *book, std::vector<char> &buffer);
+
+        /**
+         * @brief               Method loadWorkbook reads the contents of an Excel archive and stores them in the internal
+         *                      data structures.
+         * @param file_name     string name the Excel file is stored under.
+         * @param archive       archive of the Excel file, which is kept if the file is being opened lazily.
+         * @param options       options controlling how the file is opened.
+         * @return              load_report_t report of the time taken to load the file.
          */
-        static std::map<std::string, boost::property_tree::ptree> readWorkbookToTrees(zip *book);
+        static load_report_t loadWorkbook(const std::string &file_name, std::shared_ptr<WorkbookArchive> archive, const open_options_t &options);
 
         /**
-         * @brief                       Method parseSheetTrees populates the sheets map using the map of strings to
-         *                              property trees of XML by parsing the XML into sheets of rows of cells.
-         * @param file_name             string name of the Excel file that is being read.
-         * @param name_sheet_tree_map   map of sheet names to property trees of XML.
+         * @brief               Method reloadWorkbook brings an open Excel file up to date as reloadExcelFile describes.
+         * @param file_name     string name of the file to be reloaded, which is opened if it has been closed.
+         * @param options       options controlling how the file is reloaded.
+         * @return              load_report_t report of the time taken to reload the file.
          */
-        static void parseSheetTrees(std::string file_name, std::map<std::string, boost::property_tree::ptree> name_sheet_tree_map);
+        static load_report_t reloadWorkbook(const std::string &file_name, const open_options_t &options);
 
         /**
-         * @brief               Method parseSheet parses an individual sheet of XML into a sheet object that is returned.
-         * @param sheet_tree    a property tree of XML from an Excel sheet.
-         * @return              excel_parser::sheet  sheet object representation of the XML sheet.
+         * @brief                   Method storeWorkbook stores the contents of an Excel file in the internal data
+         *                          structures, unless a file with the same name is already stored.
+         * @param file_name         string name the Excel file is stored under.
+         * @param shared_strings    shared strings of the file.
+         * @param sheets            sheets of the file.
+         * @param options           options the file was opened with.
+         * @param reloadable        whether the sheets can be read again from the file, which allows them to be
+         *                          evicted to stay within the memory budget.
+         * @param signature         signatures of the parts the shared strings and sheets were read from.
+         * @note                    The shared strings and sheets are stored together so readers never see a partially
+         *                          loaded file.
          */
-        static excel_parser::sheet parseSheet(boost::property_tree::ptree sheet_tree);
+        static void storeWorkbook(const std::string &file_name, std::shared_ptr<const SharedStringTable> shared_strings, std::map<std::string, sheet_handle> sheets, const open_options_t &options, bool reloadable, workbook_signature_t signature);
 
         /**
-         * @brief           Method readFileFromArchive reads an individual file from the Excel archive into a property
-         *                  tree of XML.
+         * @brief           Method reopenArchive opens the archive of a file whose sheets have been evicted so they can
+         *                  be read again.
+         * @param file_name string name of the Excel file.
+         * @return          std::shared_ptr<WorkbookArchive> archive of the file, which is kept until the file is closed.
+         * @throws          std::runtime_error if the file is not open or cannot be read again.
+         */
+        static std::shared_ptr<WorkbookArchive> reopenArchive(const std::string &file_name);
+
+        /**
+         * @brief           Method evictSheets releases sheets chosen by the memory budget, leaving a null handle so
+         *                  that they are read again the next time they are requested, along with the columnar sheets
+         *                  and column indexes built from them.
+         * @param evicted   vector of file and sheet names of the sheets to be released, where names from derivedKey
+         *                  release only the columnar sheet and column indexes of the sheet.
+         */
+        static void evictSheets(const std::vector<SheetLru::sheet_key> &evicted);
+
+        /**
+         * @brief       Method sheetSize estimates the memory used by a sheet.
+         * @param s     sheet to be measured.
+         * @return      size_t bytes allocated from the arena of the sheet, or an estimate of its size including the
+         *              nodes of its maps if it is not held in an arena.
+         */
+        static size_t sheetSize(const sheet &s);
+
+        /**
+         * @brief               Method derivedKey names the entry of the memory budget for the columnar sheet and
+         *                      column indexes built from a sheet.
+         * @param sheet_name    string name of the sheet.
+         * @return              std::string name of the entry, which never names a sheet.
+         */
+        static std::string derivedKey(const std::string &sheet_name);
+
+        /**
+         * @brief               Method chargeDerived records the memory used by the columnar sheet and column indexes
+         *                      built from a sheet against the memory budget, as their own entry.
+         * @param file_name     string name of the file the sheet is in.
+         * @param sheet_name    string name of the sheet.
+         * @return              std::vector<SheetLru::sheet_key> entries to be evicted with evictSheets once the lock is
+         *                      released.
+         * @note                The write lock must be held.
+         */
+        static std::vector<SheetLru::sheet_key> chargeDerived(const std::string &file_name, const std::string &sheet_name);
+
+        /**
+         * @brief                   Method parseSheets streams each sheet file out of the Excel archive and parses the
+         *                          XML into sheets of rows of cells, using a pool of threads if requested.
+         * @param archive           archive of the Excel file, with its sheet files already indexed.
+         * @param options           options controlling how the file is opened.
+         * @param report            report to which the time taken to load each sheet is added.
+         * @param shared_strings    shared strings the STRING cells are resolved to, or nullptr to leave them unresolved.
+         * @return                  std::map<std::string, sheet_handle> map of sheet names to parsed sheets.
+         * @note                    libzip handles cannot be shared between threads, so each parallel task opens its
+         *                          own handle for the archive.
+         */
+        static std::map<std::string, sheet_handle> parseSheets(WorkbookArchive &archive, const open_options_t &options, load_report_t &report, std::shared_ptr<const SharedStringTable> shared_strings = nullptr);
+
+        /**
+         * @brief               Method recordSheetError records a sheet that could not be parsed in the report of its
+         *                      file, where it is left out rather than failing the whole file.
+         * @param report        report of the file the sheet is in.
+         * @param sheet_name    string name of the sheet.
+         * @param exception     exception the sheet failed with.
+         */
+        static void recordSheetError(load_report_t &report, const std::string &sheet_name, const std::exception &exception);
+
+        /**
+         * @brief               Method parseSheetFromArchive streams an individual sheet file out of the Excel archive
+         *                      and parses it into a sheet.
+         * @param book          pointer to the libzip handle for the Excel file.
+         * @param part_name     string name of the sheet file in the archive.
+         * @param timing        structure to which the time taken to load the sheet is written.
+         * @param buffer        buffer reused for the window of the XML reader.
+         * @param projection    columns and rows of the sheet to be read.
+         * @param read_ahead    whether to inflate the sheet file on a separate thread while it is parsed.
+         * @param shared_strings shared strings the STRING cells are resolved to, which the sheet keeps alive, or
+         *                      nullptr to leave them unresolved.
+         * @return              sheet_handle handle to the parsed sheet.
+         */
+        static sheet_handle parseSheetFromArchive(zip *book, const std::string &part_name, sheet_timing_t &timing, std::vector<char> &buffer, const projection_t &projection, bool read_ahead = false, std::shared_ptr<const SharedStringTable> shared_strings = nullptr);
+
+        /**
+         * @brief               Method parseSheetInChunks inflates a whole sheet file out of the Excel archive, splits
+         *                      its sheet data into chunks on row boundaries, and parses the chunks in parallel.
+         * @param book          pointer to the libzip handle for the Excel file.
+         * @param part_name     string name of the sheet file in the archive.
+         * @param timing        structure to which the time taken to load the sheet is written.
+         * @param pool          pool of threads the chunks are parsed on, which the calling thread must not belong to.
+         * @param projection    columns and rows of the sheet to be read.
+         * @param shared_strings shared strings the STRING cells are resolved to, which the sheet keeps alive, or
+         *                      nullptr to leave them unresolved.
+         * @return              sheet_handle handle to the parsed sheet.
+         */
+        static sheet_handle parseSheetInChunks(zip *book, const std::string &part_name, sheet_timing_t &timing, ThreadPool &pool, const projection_t &projection, std::shared_ptr<const SharedStringTable> shared_strings = nullptr);
+
+        /**
+         * @brief           Method splitSheetData divides the sheet data of the XML of a sheet into runs of whole rows.
+         * @param document  XML of the sheet.
+         * @param chunks    number of chunks wanted, fewer are returned if the sheet has fewer rows.
+         * @return          std::vector<std::string_view> chunks of the document in row order, each starting with a
+         *                  row that has its number, or empty if the sheet data could not be found.
+         */
+        static std::vector<std::string_view> splitSheetData(std::string_view document, size_t chunks);
+
+        /**
+         * @brief               Method parseSheet parses an individual sheet of XML into a sheet object.
+         * @param sheet_reader  reader positioned at the start of the XML of an Excel sheet.
+         * @param projection    columns and rows of the sheet to be read.
+         * @param s             empty sheet the rows are added to, whose memory resource holds their cells.
+         * @param shared_strings shared strings the STRING cells are resolved to, or nullptr to leave them unresolved.
+         */
+        static void parseSheet(XmlStreamReader &sheet_reader, const projection_t &projection, sheet &s, const SharedStringTable *shared_strings = nullptr);
+
+        /**
+         * @brief               Method readRows reads the rows of a sheet of XML one at a time, passing each to a callback.
+         * @param sheet_reader  reader positioned at the start of the XML of an Excel sheet.
+         * @param callback      function called with the row number and contents of each row.
+         * @param projection    columns and rows of the sheet to be read.
+         * @note                Only one row is held in memory at a time. Rows before the first row of the projection
+         *                      are skipped without reading their cells, and reading stops at the first row after the
+         *                      last row of the projection so the rest of the sheet file is never inflated.
+         */
+        static void readRows(XmlStreamReader &sheet_reader, const row_callback &callback, const projection_t &projection);
+
+        /**
+         * @brief               Method loadSheet reads a sheet of a lazily opened file from its archive and stores it.
+         * @param file_name     string name of the Excel file which the sheet is in.
+         * @param sheet_name    string name of the sheet to be loaded.
+         * @param archive       archive of the Excel file.
+         * @return              sheet_handle handle to the loaded sheet.
+         */
+        static sheet_handle loadSheet(const std::string &file_name, const std::string &sheet_name, std::shared_ptr<WorkbookArchive> archive);
+
+        /**
+         * @brief               Method loadSharedStrings reads the shared strings of a lazily opened file from its archive
+         *                      and stores them.
+         * @param file_name     string name of the Excel file.
+         * @param archive       archive of the Excel file.
+         * @return              std::shared_ptr<const SharedStringTable> handle to the loaded table.
+         */
+        static std::shared_ptr<const SharedStringTable> loadSharedStrings(const std::string &file_name, std::shared_ptr<WorkbookArchive> archive);
+
+        /**
+         * @brief                   Method openSchemaReader opens a cursor that reads a sheet directly from an Excel file
+         *                          for readSheetAs, resolving STRING cells to their text if required.
+         * @param file_name         string name of the Excel file which the sheet is in.
+         * @param sheet_name        string name of the sheet to be read.
+         * @param projection        columns and rows of the sheet to be read.
+         * @param resolve_strings   whether to read the shared strings and resolve STRING cells to their text.
+         * @param shared_strings    set to the shared strings the cells point at, which must outlive the cursor.
+         * @return                  std::unique_ptr<SheetReader> cursor positioned before the first row of the sheet.
+         * @throws                  std::runtime_error if the file or sheet cannot be opened.
+         */
+        static std::unique_ptr<SheetReader> openSchemaReader(const std::string &file_name, const std::string &sheet_name, projection_t projection, bool resolve_strings, std::shared_ptr<const SharedStringTable> &shared_strings);
+
+        /**
+         * @brief           Method openFileFromArchive opens an individual file from the Excel archive for inflating.
          * @param book      pointer to the libzip handle for the Excel file.
-         * @param file_name string name of the file to be read from the archive.
-         * @return          boost::property_tree::ptree  a boost property tree of XML.
+         * @param file_name string name of the file to be opened from the archive.
+         * @return          zip_file*   libzip handle for the file, which the caller must close with zip_fclose.
          * @note            The file name should not contain any path to the file as libzip will search for any files
          *                  whose name matches.
          */
-        static boost::property_tree::ptree readFileFromArchive(zip *book, std::string file_name);
+        static zip_file *openFileFromArchive(zip *book, const std::string &file_name);
 
         /**
-         * @brief       Method getAttributes retrieves the XML attributes for the top level node of a property tree of XML.
-         * @param tree  a boost property tree of XML.
-         * @return      std::map<std::string, std::string>   map of string attribute names to string attribute values.
+         * @brief           Method readFileFromArchive inflates an individual file from the Excel archive into a buffer.
+         * @param book      pointer to the libzip handle for the Excel file.
+         * @param file_name string name of the file to be read from the archive.
+         * @param contents  buffer resized to the uncompressed size of the file and filled with its contents, which
+         *                  keeps its capacity so reading another file into it only allocates if that file is larger.
+         * @throws          std::runtime_error if the file cannot be found or inflated.
+         * @note            The file name should not contain any path to the file as libzip will search for any files
+         *                  whose name matches.
          */
-        static std::map<std::string, std::string> getAttributes(boost::property_tree::ptree tree);
+        static void readFileFromArchive(zip *book, const std::string &file_name, std::vector<char> &contents);
 
     public:
         /**
@@ -156,22 +500,221 @@ namespace excel_parser
         /**
          * @brief           Method openExcelFile opens an Excel file and parses its contents into internal data structures.
          * @param file_name string name of the file to be opened.
+         * @note            The file is parsed without holding the lock, so other files can be read while it loads. If
+         *                  the same file is opened by several threads at once, the first to finish is stored.
+         */
+        static void openExcelFile(const std::string &file_name);
+
+        /**
+         * @brief           Method openExcelFile opens an Excel file and parses its contents into internal data structures.
+         * @param file_name string name of the file to be opened.
+         * @param options   options controlling how the file is opened.
+         * @return          load_report_t report of the time taken to load the file, which is empty if the file was
+         *                  already open.
+         * @throws          std::runtime_error if the file or its workbook cannot be read.
+         * @note            A sheet that cannot be parsed does not fail the file, it is left out and listed in the
+         *                  sheet_errors of the report instead.
+         */
+        static load_report_t openExcelFile(const std::string &file_name, const open_options_t &options);
+
+        /**
+         * @brief           Method tryOpenExcelFile opens an Excel file like openExcelFile, but reports a failure in its
+         *                  result instead of throwing.
+         * @param file_name string name of the file to be opened.
+         * @param options   options controlling how the file is opened.
+         * @return          open_result_t outcome of opening the file, with the report of the time taken on success.
+         */
+        static open_result_t tryOpenExcelFile(const std::string &file_name, const open_options_t &options = open_options_t()) noexcept;
+
+        /**
+         * @brief           Method openExcelBuffer parses the contents of an Excel file held in memory into internal data
+         *                  structures.
+         * @param file_name string name to store the file under, which is used to access it like any other file.
+         * @param contents  contents of the Excel file, which are moved into the parser rather than copied.
+         * @param options   options controlling how the file is opened, memory_map and cache_directory are ignored.
+         * @return          load_report_t report of the time taken to load the file, which is empty if a file with the
+         *                  same name was already open.
+         * @throws          std::runtime_error if the contents are not an Excel file or its workbook cannot be read.
          */
-        static void openExcelFile(std::string file_name);
+        static load_report_t openExcelBuffer(const std::string &file_name, std::vector<char> contents, open_options_t options = open_options_t());
+
+        /**
+         * @brief           Method tryOpenExcelBuffer parses an Excel file held in memory like openExcelBuffer, but
+         *                  reports a failure in its result instead of throwing.
+         * @param file_name string name to store the file under, which is used to access it like any other file.
+         * @param contents  contents of the Excel file, which are moved into the parser rather than copied.
+         * @param options   options controlling how the file is opened, memory_map and cache_directory are ignored.
+         * @return          open_result_t outcome of opening the file, with the report of the time taken on success.
+         */
+        static open_result_t tryOpenExcelBuffer(const std::string &file_name, std::vector<char> contents, open_options_t options = open_options_t()) noexcept;
+
+        /**
+         * @brief               Method openExcelFiles opens a batch of Excel files concurrently and parses their contents
+         *                      into internal data structures.
+         * @param file_names    vector of names of the files to be opened.
+         * @param options       options controlling how every file is opened, where threads is the number of files
+         *                      opened at once (0 uses the number of hardware threads).
+         * @return              std::vector<batch_result_t> outcome of opening each file, in the order of file_names.
+         * @note                Each file is read, inflated, and parsed on one worker of a work stealing pool, so
+         *                      different files are at different stages at once. A file that cannot be opened is
+         *                      reported as failed without affecting the rest of the batch.
+         */
+        static std::vector<batch_result_t> openExcelFiles(const std::vector<std::string> &file_names, const open_options_t &options = open_options_t());
 
         /**
          * @brief           Method closeExcelFile closes and discards the data of an Excel file.
          * @param file_name string name of the file to be opened.
          */
-        static void closeExcelFile(std::string file_name);
+        static void closeExcelFile(const std::string &file_name);
+
+        /**
+         * @brief           Method reloadExcelFile brings an open Excel file up to date with its contents on disk,
+         *                  parsing only the sheets and shared strings whose files have changed, with the options the
+         *                  file was last opened or reloaded with.
+         * @param file_name string name of the file to be reloaded, which is opened if it is not already open.
+         * @return          load_report_t report of the time taken to reload the file, where reused_sheets is the
+         *                  number of sheets kept from the previous version.
+         * @throws          std::runtime_error if the file was opened with openExcelBuffer, or if the file or its
+         *                  workbook cannot be read.
+         * @note            Parts are compared by the CRC32 and uncompressed size recorded in the central directory
+         *                  of the archive, so unchanged parts are never inflated. The new version is parsed without
+         *                  holding the lock and its shared strings and sheets are published together, so readers see
+         *                  either the old or the new version of the file. Handles to replaced sheets stay valid.
+         */
+        static load_report_t reloadExcelFile(const std::string &file_name);
+
+        /**
+         * @brief           Method reloadExcelFile brings an open Excel file up to date with its contents on disk like
+         *                  reloadExcelFile above, with new options that are kept for later reloads.
+         * @param file_name string name of the file to be reloaded, which is opened if it is not already open.
+         * @param options   options controlling how the file is reloaded.
+         * @return          load_report_t report of the time taken to reload the file.
+         * @throws          std::runtime_error if the file was opened with openExcelBuffer, or if the file or its
+         *                  workbook cannot be read.
+         */
+        static load_report_t reloadExcelFile(const std::string &file_name, const open_options_t &options);
+
+        /**
+         * @brief           Method tryReloadExcelFile reloads an Excel file like reloadExcelFile, with the options it was
+         *                  last opened or reloaded with, but reports a failure in its result instead of throwing.
+         * @param file_name string name of the file to be reloaded, which is opened if it is not already open.
+         * @return          open_result_t outcome of reloading the file, with the report of the time taken on success.
+         * @note            The previous version of the file is kept when the reload fails.
+         */
+        static open_result_t tryReloadExcelFile(const std::string &file_name) noexcept;
+
+        /**
+         * @brief           Method tryReloadExcelFile reloads an Excel file like reloadExcelFile with new options, but
+         *                  reports a failure in its result instead of throwing.
+         * @param file_name string name of the file to be reloaded, which is opened if it is not already open.
+         * @param options   options controlling how the file is reloaded.
+         * @return          open_result_t outcome of reloading the file, with the report of the time taken on success.
+         * @note            The previous version of the file is kept when the reload fails.
+         */
+        static open_result_t tryReloadExcelFile(const std::string &file_name, const open_options_t &options) noexcept;
 
         /**
          * @brief               Method getSheet returns the sheet object with the given name from the specified file.
          * @param file_name     string name of the file which the sheet is in.
          * @param sheet_name    string name of the sheet of which to get the associated object.
          * @return              sheet object with the data contained within the sheet.
+         * @note                The sheet is copied, use getSheetHandle to access it without copying. The text of
+         *                      the cells of the copy is still held by the loaded sheet and the shared strings of the
+         *                      file, so cell_t::getText must only be called on the copy while a handle to the sheet
+         *                      from getSheetHandle is held, which keeps them alive even after the file is closed.
+         */
+        static sheet getSheet(const std::string &file_name, const std::string &sheet_name);
+
+        /**
+         * @brief               Method getSheetHandle returns a shared handle to the stored sheet with the given name
+         *                      from the specified file.
+         * @param file_name     string name of the file which the sheet is in.
+         * @param sheet_name    string name of the sheet of which to get the handle.
+         * @return              sheet_handle immutable handle to the data contained within the sheet.
+         * @note                The handle keeps the sheet alive even if closeExcelFile is called for the file.
+         */
+        static sheet_handle getSheetHandle(const std::string &file_name, const std::string &sheet_name);
+
+        /**
+         * @brief               Method getColumnarSheet returns the columnar representation of the sheet with the given
+         *                      name from the specified file.
+         * @param file_name     string name of the file which the sheet is in.
+         * @param sheet_name    string name of the sheet of which to get the columnar representation.
+         * @return              ColumnarSheet object with the data contained within the sheet.
+         * @note                The columnar representation is built on the first call and kept until the file is closed.
+         *                      The representation is copied, use getColumnarSheetHandle to access it without copying.
+         */
+        static ColumnarSheet getColumnarSheet(const std::string &file_name, const std::string &sheet_name);
+
+        /**
+         * @brief               Method getColumnarSheetHandle returns a shared handle to the columnar representation of
+         *                      the sheet with the given name from the specified file.
+         * @param file_name     string name of the file which the sheet is in.
+         * @param sheet_name    string name of the sheet of which to get the columnar representation.
+         * @return              std::shared_ptr<const ColumnarSheet> immutable handle to the columnar representation.
+         * @note                The handle keeps the representation alive even if closeExcelFile is called for the file.
+         */
+        static std::shared_ptr<const ColumnarSheet> getColumnarSheetHandle(const std::string &file_name, const std::string &sheet_name);
+
+        /**
+         * @brief               Method getColumnIndex returns a shared handle to an index of the values of a column of
+         *                      the sheet with the given name from the specified file.
+         * @param file_name     string name of the file which the sheet is in.
+         * @param sheet_name    string name of the sheet holding the column.
+         * @param column_name   column letters (e.g. "B").
+         * @param type          structure of the index, HASH_INDEX for equality lookups or SORTED_INDEX for numeric
+         *                      range lookups as well.
+         * @return              std::shared_ptr<const ColumnIndex> immutable handle to the index.
+         * @throws              std::runtime_error if the sheet cannot be found or the column letters are invalid.
+         * @note                The index is built on the first call and kept until it or the sheet is evicted, reloaded, or
+         *                      its file is closed. The handle keeps the index alive even if closeExcelFile is called.
+         */
+        static std::shared_ptr<const ColumnIndex> getColumnIndex(const std::string &file_name, const std::string &sheet_name, const std::string &column_name, IndexType type = HASH_INDEX);
+
+        /**
+         * @brief               Method aggregateColumn computes the count, sum, minimum, maximum, and mean of the numbers
+         *                      in a column of the sheet with the given name from the specified file.
+         * @param file_name     string name of the file which the sheet is in.
+         * @param sheet_name    string name of the sheet holding the column.
+         * @param column_name   column letters (e.g. "B").
+         * @param threads       number of threads the column is split across, 0 uses the number of hardware threads.
+         * @return              aggregate_t aggregates of the NUMBER cells of the column, with the mean returned by
+         *                      aggregate_t::mean, which is NaN if the column holds no numbers.
+         * @throws              std::runtime_error if the sheet cannot be found.
+         * @note                The aggregates are computed over the columnar representation of the sheet, which is
+         *                      built on the first call as with getColumnarSheetHandle.
          */
-        static sheet getSheet(std::string file_name, std::string sheet_name);
+        static aggregate_t aggregateColumn(const std::string &file_name, const std::string &sheet_name, const std::string &column_name, unsigned int threads = 1);
+
+        /**
+         * @brief               Method aggregateColumn computes the count, sum, minimum, maximum, and mean of the numbers
+         *                      in a closed range in a column of the sheet with the given name from the specified file.
+         * @param file_name     string name of the file which the sheet is in.
+         * @param sheet_name    string name of the sheet holding the column.
+         * @param column_name   column letters (e.g. "B").
+         * @param low           lowest value to be included.
+         * @param high          highest value to be included.
+         * @param threads       number of threads the column is split across, 0 uses the number of hardware threads.
+         * @return              aggregate_t aggregates of the NUMBER cells of the column in the range, with the mean
+         *                      returned by aggregate_t::mean, which is NaN if no numbers are in the range.
+         * @throws              std::runtime_error if the sheet cannot be found.
+         */
+        static aggregate_t aggregateColumn(const std::string &file_name, const std::string &sheet_name, const std::string &column_name, double low, double high, unsigned int threads = 1);
+
+        /**
+         * @brief               Method exportSheetToArrow exports the sheet with the given name from the specified file
+         *                      through the Apache Arrow C Data Interface, as a struct array with one field per column.
+         * @param file_name     string name of the file which the sheet is in.
+         * @param sheet_name    string name of the sheet to be exported, which is also the name of the struct field.
+         * @param array         array to be filled, which the caller must release.
+         * @param schema        schema to be filled, which the caller must release.
+         * @throws              std::runtime_error if the sheet cannot be found.
+         * @note                The arrays point into the columnar representation of the sheet, built on the first call
+         *                      as with getColumnarSheetHandle, and the shared strings of the file, both of which are kept
+         *                      alive until the array is released even if closeExcelFile is called. See ArrowExporter for
+         *                      the types the columns are exported as.
+         */
+        static void exportSheetToArrow(const std::string &file_name, const std::string &sheet_name, ArrowArray *array, ArrowSchema *schema);
 
         /**
          * @brief                       Method getSharedString retrieves the Shared String with the given index in the
@@ -179,17 +722,131 @@ namespace excel_parser
          * @param file_name             string name of the file which the shared string is in.
          * @param shared_string_index   index of the shared string in the file.
          * @return                      std::string value of the string at the given index.
-         * @note                        The index of the shared string is simply the int value of a cell_t structure when
-         *                              the CellType is STRING.
+         * @note                        The index of the shared string is the getStringIndex value of a cell_t structure
+         *                              when the CellType is STRING.
          */
-        static std::string getSharedString(std::string file_name, int shared_string_index);
+        static std::string getSharedString(const std::string &file_name, int shared_string_index);
+
+        /**
+         * @brief                       Method getSharedStringView retrieves a view of the Shared String with the given
+         *                              index in the specified file without copying it.
+         * @param file_name             string name of the file which the shared string is in.
+         * @param shared_string_index   index of the shared string in the file.
+         * @return                      std::string_view view of the string at the given index.
+         * @note                        The view is only valid until the file is closed, use getSharedStringTable to
+         *                              keep the strings alive for longer.
+         */
+        static std::string_view getSharedStringView(const std::string &file_name, int shared_string_index);
+
+        /**
+         * @brief           Method getSharedStringTable retrieves a shared handle to the table of Shared Strings in the
+         *                  specified file.
+         * @param file_name string name of the file which the shared strings are in.
+         * @return          std::shared_ptr<const SharedStringTable> immutable handle to the table.
+         * @note            The handle keeps the table alive even if closeExcelFile is called for the file.
+         */
+        static std::shared_ptr<const SharedStringTable> getSharedStringTable(const std::string &file_name);
 
         /**
          * @brief           Method getSheetNames retrieves the names of all the sheets in a given Excel file.
          * @param file_name Name of the file from which to retrive all the sheet names.
          * @return          std::vector<std::string> of names of sheets.
          */
-        static std::vector<std::string> getSheetNames(std::string file_name);
+        static std::vector<std::string> getSheetNames(const std::string &file_name);
+
+        /**
+         * @brief           Method setMemoryBudget limits the memory used by the sheets held by the parser.
+         * @param bytes     budget in bytes, 0 for unlimited which is the default.
+         * @note            When the estimated size of the loaded sheets exceeds the budget, the least recently used
+         *                  sheets are released and read again from their file the next time they are requested.
+         *                  Columnar sheets and column indexes are counted too, and are released apart from the sheet
+         *                  they were built from and built again when next requested. Sheets of files opened from
+         *                  buffers are never released, and shared strings are always kept. Handles that are already
+         *                  held keep their sheet alive after it is released.
+         */
+        static void setMemoryBudget(size_t bytes);
+
+        /**
+         * @brief   Method getCacheStats retrieves the counters of the memory budget.
+         * @return  cache_stats_t budget, estimated usage, and the number of hits, misses, and evictions.
+         */
+        static cache_stats_t getCacheStats();
+
+        /**
+         * @brief           Method setInstrumentation starts or stops collecting the cumulative usage counters.
+         * @param enabled   whether the counters are collected, which is off by default.
+         * @note            Collecting the counters times every acquisition of the reader-writer lock.
+         */
+        static void setInstrumentation(bool enabled);
+
+        /**
+         * @brief   Method getUsageStats retrieves the cumulative usage counters.
+         * @return  usage_stats_t counters collected since they were last reset.
+         */
+        static usage_stats_t getUsageStats();
+
+        /**
+         * @brief   Method resetUsageStats sets all the cumulative usage counters to zero.
+         */
+        static void resetUsageStats();
+
+        /**
+         * @brief               Method streamSheet reads a sheet directly from an Excel file one row at a time, without
+         *                      storing the sheet in the internal data structures.
+         * @param file_name     string name of the Excel file which the sheet is in.
+         * @param sheet_name    string name of the sheet to be read.
+         * @param callback      function called with the row number and contents of each row in order.
+         * @param projection    columns and rows of the sheet to be read, which is the whole sheet by default.
+         * @note                The file does not need to have been opened with openExcelFile. Cells of type STRING
+         *                      hold shared string indices, which can only be resolved once the file has been opened.
+         */
+        static void streamSheet(const std::string &file_name, const std::string &sheet_name, const row_callback &callback, projection_t projection = projection_t());
+
+        /**
+         * @brief               Method openSheetReader opens a cursor that reads a sheet directly from an Excel file one
+         *                      row at a time, without storing the sheet in the internal data structures.
+         * @param file_name     string name of the Excel file which the sheet is in.
+         * @param sheet_name    string name of the sheet to be read.
+         * @param projection    columns and rows of the sheet to be read, which is the whole sheet by default.
+         * @return              std::unique_ptr<SheetReader> cursor positioned before the first row of the sheet, which
+         *                      keeps the archive open until it is destroyed.
+         * @throws              std::runtime_error if the file or sheet cannot be opened.
+         * @note                Rows are inflated and parsed as the cursor advances, so memory use is bounded by the
+         *                      largest row rather than the size of the sheet.
+         */
+        static std::unique_ptr<SheetReader> openSheetReader(const std::string &file_name, const std::string &sheet_name, projection_t projection = projection_t());
+
+        /**
+         * @brief               Method readSheetAs reads the rows of a sheet with a fixed schema directly from an Excel
+         *                      file into records, without storing the sheet in the internal data structures.
+         * @tparam Schema       schema_t describing the record each row is read into and the column of each member.
+         * @param file_name     string name of the Excel file which the sheet is in.
+         * @param sheet_name    string name of the sheet to be read.
+         * @param first_row     number of the first row to be read, such as 2 to skip a header row.
+         * @param last_row      number of the last row to be read.
+         * @return              std::vector<typename Schema::record_type> one record per row of the sheet in order.
+         * @throws              std::runtime_error if the file or sheet cannot be opened.
+         * @note                The file does not need to have been opened with openExcelFile. Only the columns of the
+         *                      schema are parsed, and the shared strings are only read if a member is a string.
+         */
+        template <typename Schema>
+        static std::vector<typename Schema::record_type> readSheetAs(const std::string &file_name, const std::string &sheet_name, int first_row = 1, int last_row = std::numeric_limits<int>::max())
+        {
+            projection_t projection;
+            projection.columns = Schema::columns();
+            projection.first_row = first_row;
+            projection.last_row = last_row;
+            std::shared_ptr<const SharedStringTable> shared_strings;
+            std::unique_ptr<SheetReader> cursor = openSchemaReader(file_name, sheet_name, std::move(projection), Schema::reads_text, shared_strings);
+
+            std::vector<typename Schema::record_type> records;
+            while (cursor->next())
+            {
+                records.emplace_back();
+                Schema::read(cursor->getRow(), records.back());
+            }
+            return records;
+        }
     };
 }
 
@@ -0,0 +1,354 @@
+/**
+ * @file    ExcelTypes.hpp
+ * @author  James Horner
+ * @brief   This file contains the declarations of the types used to represent the contents of Excel files.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef ExcelTypes_HPP
+#define ExcelTypes_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CellReference.hpp"
+
+namespace excel_parser
+{
+    /**
+     * @brief Enumeration of the different value types a cell can take.
+     */
+    typedef enum
+    {
+        NUMBER,
+        STRING,
+        INLINE_STRING,
+        ERROR
+    } CellType;
+
+    /**
+     * @brief   Structural representation of the type and contents of a cell.
+     * @details The value of a cell is parsed once when the sheet is loaded. NUMBER cells hold their numeric value
+     *          (booleans are 0 or 1) and STRING cells hold the index of their shared string. STRING cells of files
+     *          opened with resolve_strings also point at the text of their shared string, so reading it needs no call
+     *          back into the ExcelParser. INLINE_STRING cells point at text stored with the sheet rather than in the
+     *          shared strings, such as formula string results, inline strings, and ISO 8601 dates, and ERROR cells at
+     *          an error value such as "#DIV/0!". The index shares the padding after the type, so a cell is 16 bytes.
+     */
+    struct cell_t
+    {
+        CellType type;
+        uint32_t string_index;
+        union
+        {
+            double number;
+            const std::string_view *text;
+        };
+
+        /**
+         * @brief       Method makeNumber creates a NUMBER cell.
+         * @param value numeric value of the cell.
+         * @return      cell_t the cell.
+         */
+        static cell_t makeNumber(double value)
+        {
+            cell_t c;
+            c.type = NUMBER;
+            c.number = value;
+            return c;
+        }
+
+        /**
+         * @brief       Method makeString creates a STRING cell.
+         * @param index index of the shared string of the cell.
+         * @param text  text of the shared string, or nullptr if the string is not resolved.
+         * @return      cell_t the cell.
+         */
+        static cell_t makeString(uint32_t index, const std::string_view *text = nullptr)
+        {
+            cell_t c;
+            c.type = STRING;
+            c.string_index = index;
+            c.text = text;
+            return c;
+        }
+
+        /**
+         * @brief       Method makeText creates a INLINE_STRING or ERROR cell.
+         * @param type  INLINE_STRING or ERROR.
+         * @param text  text of the cell, which must outlive the cell.
+         * @return      cell_t the cell.
+         */
+        static cell_t makeText(CellType type, const std::string_view *text)
+        {
+            cell_t c;
+            c.type = type;
+            c.string_index = 0;
+            c.text = text;
+            return c;
+        }
+
+        /**
+         * @brief   Method getNumber retrieves the value of a NUMBER cell.
+         * @return  double numeric value of the cell, only meaningful when the type is NUMBER.
+         */
+        double getNumber() const { return number; }
+
+        /**
+         * @brief   Method getStringIndex retrieves the shared string index of a STRING cell.
+         * @return  uint32_t index to be passed to ExcelParser::getSharedString, only meaningful when the type is STRING.
+         */
+        uint32_t getStringIndex() const { return string_index; }
+
+        /**
+         * @brief   Method hasText checks whether the cell holds text, either its own or a shared string resolved when
+         *          its sheet was loaded.
+         * @return  true if the cell is a INLINE_STRING or ERROR cell or a resolved STRING, and getText can be called.
+         */
+        bool hasText() const { return type != NUMBER && text != nullptr; }
+
+        /**
+         * @brief   Method getText retrieves the text of a INLINE_STRING or ERROR cell or of a resolved STRING cell.
+         * @return  std::string_view text of the cell, only meaningful when hasText is true.
+         * @note    The text is held by the memory of the sheet or by the shared strings of the file, which are kept
+         *          alive by the sheet the cell was loaded into, so it stays valid for as long as a handle to that sheet
+         *          is held. Copies of the cell, including those in a sheet returned by ExcelParser::getSheet, still
+         *          point at the same text, so they must not be read after the last handle is released.
+         */
+        std::string_view getText() const { return *text; }
+    };
+
+    /**
+     * @brief   Class Row holds the cells of a row in a sheet keyed by their 0 based column index.
+     * @details Cells are kept in a flat vector sorted by column index, so a row is a single allocation, iteration is
+     *          sequential, and lookups are a binary search. Column letters are only decoded when a lookup is made by
+     *          name, and can be produced for a cell with columnName or cellReference. The cells are allocated from the
+     *          memory resource of the sheet holding the row, while copies made outside a sheet use the default resource.
+     */
+    class Row
+    {
+    public:
+        /// Type of the entries of the row, the column index and the cell.
+        using value_type = std::pair<int, cell_t>;
+        /// Type of the iterators over the entries of the row in column order.
+        using const_iterator = std::pmr::vector<value_type>::const_iterator;
+        /// Type of the allocator the cells are allocated with, which lets a sheet pass its memory resource to its rows.
+        using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+        Row() = default;
+        Row(const Row &other) = default;
+        Row(Row &&other) = default;
+        Row &operator=(const Row &other) = default;
+        Row &operator=(Row &&other) = default;
+
+        /**
+         * @brief           Constructor for an empty Row whose cells are allocated with an allocator.
+         * @param allocator allocator for the cells.
+         */
+        explicit Row(const allocator_type &allocator) : cells(allocator) {}
+
+        /**
+         * @brief           Constructor for a copy of a Row whose cells are allocated with an allocator.
+         * @param other     row to be copied.
+         * @param allocator allocator for the cells.
+         */
+        Row(const Row &other, const allocator_type &allocator) : cells(other.cells, allocator) {}
+
+        /**
+         * @brief           Constructor moving a Row into storage allocated with an allocator.
+         * @param other     row to be moved.
+         * @param allocator allocator for the cells.
+         */
+        Row(Row &&other, const allocator_type &allocator) : cells(std::move(other.cells), allocator) {}
+
+        const_iterator begin() const { return cells.begin(); }
+        const_iterator end() const { return cells.end(); }
+
+        /**
+         * @brief   Method size retrieves the number of cells in the row.
+         * @return  size_t number of cells.
+         */
+        size_t size() const { return cells.size(); }
+
+        /**
+         * @brief   Method empty checks whether the row holds no cells.
+         * @return  true if the row holds no cells.
+         */
+        bool empty() const { return cells.empty(); }
+
+        /**
+         * @brief   Method capacity retrieves the number of cells the row can hold without reallocating.
+         * @return  size_t number of cells.
+         */
+        size_t capacity() const { return cells.capacity(); }
+
+        /**
+         * @brief   Method clear removes every cell from the row, keeping its storage for reuse.
+         */
+        void clear() { cells.clear(); }
+
+        /**
+         * @brief               Method set stores a cell in the row, replacing any cell already in its column.
+         * @param column_index  0 based index of the column.
+         * @param c             cell to be stored.
+         * @note                Cells are appended in constant time when set in column order, as they are in a sheet.
+         */
+        void set(int column_index, cell_t c)
+        {
+            if (cells.empty() || cells.back().first < column_index)
+            {
+                cells.emplace_back(column_index, c);
+                return;
+            }
+            auto it = lowerBound(column_index);
+            if (it != cells.end() && it->first == column_index)
+            {
+                it->second = c;
+            }
+            else
+            {
+                cells.emplace(it, column_index, c);
+            }
+        }
+
+        /**
+         * @brief               Method find searches the row for the cell in a column.
+         * @param column_index  0 based index of the column.
+         * @return              const cell_t* pointer to the cell, or nullptr if the column holds no cell.
+         */
+        const cell_t *find(int column_index) const
+        {
+            auto it = lowerBound(column_index);
+            return it != cells.end() && it->first == column_index ? &it->second : nullptr;
+        }
+
+        /**
+         * @brief               Method find searches the row for the cell in a column.
+         * @param column_name   column letters (e.g. "A").
+         * @return              const cell_t* pointer to the cell, or nullptr if the column holds no cell.
+         */
+        const cell_t *find(std::string_view column_name) const { return find(columnIndex(column_name)); }
+
+        /**
+         * @brief               Method at retrieves the cell in a column.
+         * @param column_index  0 based index of the column.
+         * @return              const cell_t& the cell.
+         * @throws              std::out_of_range if the column holds no cell.
+         */
+        const cell_t &at(int column_index) const
+        {
+            const cell_t *c = find(column_index);
+            if (c == nullptr)
+            {
+                throw std::out_of_range("[Excel Parser] (ERROR) No cell in column " + columnName(column_index));
+            }
+            return *c;
+        }
+
+        /**
+         * @brief               Method at retrieves the cell in a column.
+         * @param column_name   column letters (e.g. "A").
+         * @return              const cell_t& the cell.
+         * @throws              std::out_of_range if the column holds no cell.
+         */
+        const cell_t &at(std::string_view column_name) const { return at(columnIndex(column_name)); }
+
+        /**
+         * @brief               Method count checks whether a column holds a cell.
+         * @param column_index  0 based index of the column.
+         * @return              size_t 1 if the column holds a cell, 0 otherwise.
+         */
+        size_t count(int column_index) const { return find(column_index) != nullptr; }
+
+        /**
+         * @brief               Method count checks whether a column holds a cell.
+         * @param column_name   column letters (e.g. "A").
+         * @return              size_t 1 if the column holds a cell, 0 otherwise.
+         */
+        size_t count(std::string_view column_name) const { return find(column_name) != nullptr; }
+
+    private:
+        /**
+         * @brief               Method lowerBound finds the first entry at or after a column.
+         * @param column_index  0 based index of the column.
+         * @return              iterator to the entry.
+         */
+        std::pmr::vector<value_type>::const_iterator lowerBound(int column_index) const
+        {
+            return std::lower_bound(cells.begin(), cells.end(), column_index, [](const value_type &entry, int index)
+                                    { return entry.first < index; });
+        }
+        std::pmr::vector<value_type>::iterator lowerBound(int column_index)
+        {
+            return std::lower_bound(cells.begin(), cells.end(), column_index, [](const value_type &entry, int index)
+                                    { return entry.first < index; });
+        }
+
+        /// Cells of the row sorted by column index.
+        std::pmr::vector<value_type> cells;
+    };
+
+    /**
+     * @brief   Type definition representing a row of cells in a sheet.
+     */
+    using row = Row;
+
+    /**
+     * @brief   Type definition representing a sheet in an Excel file.
+     * @note    Sheets loaded by the ExcelParser are allocated from a SheetArena, and copies of them use the default
+     *          memory resource.
+     */
+    using sheet = std::pmr::map<int, row>;
+
+    /**
+     * @brief   Type definition representing an immutable, shared handle to a sheet stored by the ExcelParser.
+     * @note    The sheet stays valid for as long as the handle is held, even if its file is closed.
+     */
+    using sheet_handle = std::shared_ptr<const sheet>;
+
+    /**
+     * @brief   Type definition representing a map of XML attribute names to attribute values. 
+     */
+    using xml_attributes = std::map<std::string, std::string>;
+
+    /**
+     * @brief   Type definition of the function called for each row of a streamed sheet.
+     * @note    The row is only valid for the duration of the call, as its storage is reused for the next row.
+     */
+    using row_callback = std::function<void(int row_id, const row &r)>;
+
+    /**
+     * @brief   Structural representation of the part of a sheet to be read.
+     * @details Cells outside the columns and rows of the projection are skipped without being stored, and reading a
+     *          sheet stops as soon as a row past the last row is reached.
+     */
+    struct projection_t
+    {
+        /// Letters of the columns to be read (e.g. "A"), every column is read if empty.
+        std::set<std::string> columns;
+        /// Number of the first row to be read.
+        int first_row = 1;
+        /// Number of the last row to be read.
+        int last_row = std::numeric_limits<int>::max();
+
+        /**
+         * @brief   Method readsWholeSheet checks whether the projection includes every cell of a sheet.
+         * @return  true if no columns or rows are excluded.
+         */
+        bool readsWholeSheet() const { return columns.empty() && first_row <= 1 && last_row == std::numeric_limits<int>::max(); }
+    };
+}
+
+#endif /* ExcelTypes_HPP */
@@ -0,0 +1,78 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+MappedFile::MappedFile(const std::string &file_name) : data(nullptr), size(0)
+{
+	std::string error_message = "[Excel Parser] (ERROR) Error mapping file into memory: " + file_name;
+#ifdef _WIN32
+	file_handle = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error(error_message);
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file_handle);
+		throw std::runtime_error(error_message);
+	}
+	mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle == nullptr)
+	{
+		CloseHandle(file_handle);
+		throw std::runtime_error(error_message);
+	}
+	void *view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+		throw std::runtime_error(error_message);
+	}
+	size = static_cast<size_t>(file_size.QuadPart);
+#else
+	int descriptor = open(file_name.c_str(), O_RDONLY);
+	if (descriptor < 0)
+	{
+		throw std::runtime_error(error_message);
+	}
+	struct stat file_stat;
+	if (fstat(descriptor, &file_stat) != 0 || file_stat.st_size == 0)
+	{
+		close(descriptor);
+		throw std::runtime_error(error_message);
+	}
+	void *view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (view == MAP_FAILED)
+	{
+		throw std::runtime_error(error_message);
+	}
+	size = static_cast<size_t>(file_stat.st_size);
+#endif
+	data = static_cast<const char *>(view);
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+#else
+	munmap(const_cast<char *>(data), size);
+#endif
+}
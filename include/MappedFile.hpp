@@ -0,0 +1,64 @@
+/**
+ * @file    MappedFile.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the MappedFile, a read only memory mapping of a file.
+ * @details The MappedFile maps the whole of a file into memory, so its contents can be read in place without copying
+ *          them into a buffer. It is used for Excel files opened with memory_map and for the files of the
+ *          WorkbookCache.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef MappedFile_HPP
+#define MappedFile_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace excel_parser
+{
+    /**
+     * @brief   Class MappedFile maps a file into memory for reading for as long as it exists.
+     * @note    The mapping is private, so the contents only change if the file is modified in place while mapped.
+     */
+    class MappedFile
+    {
+    public:
+        /**
+         * @brief           Constructor for the MappedFile class which maps a file into memory.
+         * @param file_name string name of the file to be mapped.
+         * @throws          std::runtime_error if the file cannot be opened or mapped, or is empty.
+         */
+        explicit MappedFile(const std::string &file_name);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        void operator=(const MappedFile &) = delete;
+
+        /**
+         * @brief   Method getData retrieves the contents of the file.
+         * @return  const char* pointer to the first byte of the mapping, which is aligned to a page.
+         */
+        const char *getData() const { return data; }
+
+        /**
+         * @brief   Method getSize retrieves the size of the file.
+         * @return  size_t number of bytes of the mapping.
+         */
+        size_t getSize() const { return size; }
+
+    private:
+        /// Pointer to the first byte of the mapping.
+        const char *data;
+        /// Number of bytes of the mapping.
+        size_t size;
+#ifdef _WIN32
+        /// Windows handles for the mapped file and the mapping.
+        void *file_handle, *mapping_handle;
+#endif
+    };
+}
+
+#endif /* MappedFile_HPP */
@@ -0,0 +1,91 @@
+#include "SharedStringTable.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+uint32_t SharedStringTable::append(std::string_view s)
+{
+	// The table is kept at most half full so probe sequences stay short.
+	if ((interned + 1) * 2 > intern_slots.size())
+	{
+		growInternSlots();
+	}
+	uint32_t hash = static_cast<uint32_t>(std::hash<std::string_view>()(s));
+	size_t mask = intern_slots.size() - 1;
+	for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+	{
+		intern_slot_t &entry = intern_slots[slot];
+		if (entry.index == empty_slot)
+		{
+			span_t span;
+			span.offset = arena.size();
+			span.length = static_cast<uint32_t>(s.size());
+			arena.append(s.data(), s.size());
+			spans.push_back(span);
+			entry.index = static_cast<uint32_t>(spans.size() - 1);
+			entry.hash = hash;
+			++interned;
+			return entry.index;
+		}
+		if (entry.hash == hash && at(entry.index) == s)
+		{
+			spans.push_back(spans[entry.index]);
+			return static_cast<uint32_t>(spans.size() - 1);
+		}
+	}
+}
+
+void SharedStringTable::finish()
+{
+	std::vector<intern_slot_t>().swap(intern_slots);
+	interned = 0;
+	arena.shrink_to_fit();
+	spans.shrink_to_fit();
+}
+
+void SharedStringTable::buildViews()
+{
+	views.clear();
+	views.reserve(spans.size());
+	for (auto &span : spans)
+	{
+		views.emplace_back(arena.data() + span.offset, span.length);
+	}
+}
+
+std::string_view SharedStringTable::at(size_t index) const
+{
+	if (index >= spans.size())
+	{
+		throw std::out_of_range("[Excel Parser] (ERROR) Shared string index " + std::to_string(index) + " is out of range.");
+	}
+	return std::string_view(arena.data() + spans[index].offset, spans[index].length);
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+void SharedStringTable::growInternSlots()
+{
+	std::vector<intern_slot_t> slots(std::max<size_t>(64, intern_slots.size() * 2), intern_slot_t{empty_slot, 0});
+	size_t mask = slots.size() - 1;
+	for (auto &entry : intern_slots)
+	{
+		if (entry.index != empty_slot)
+		{
+			size_t slot = entry.hash & mask;
+			while (slots[slot].index != empty_slot)
+			{
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = entry;
+		}
+	}
+	intern_slots.swap(slots);
+}
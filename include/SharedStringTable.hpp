@@ -0,0 +1,138 @@
+/**
+ * @file    SharedStringTable.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the SharedStringTable which stores the shared strings of an Excel file.
+ * @details All the strings are stored back to back in a single character arena and addressed by index through a
+ *          vector of spans, so lookups are O(1). Strings are interned through an open addressing table of span
+ *          indices, so building the table makes a handful of allocations regardless of how many strings it holds.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef SharedStringTable_HPP
+#define SharedStringTable_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace excel_parser
+{
+    /**
+     * @brief   Class SharedStringTable is a contiguous, indexed store of the shared strings of an Excel file.
+     * @details Identical strings are interned while the table is built, so they share the same storage in the arena.
+     */
+    class SharedStringTable
+    {
+    public:
+        /**
+         * @brief       Method append adds a string to the end of the table.
+         * @param s     string to be added.
+         * @return      uint32_t index of the string in the table.
+         */
+        uint32_t append(std::string_view s);
+
+        /**
+         * @brief       Method finish releases the memory used to intern strings once the table is complete.
+         */
+        void finish();
+
+        /**
+         * @brief       Method at retrieves the string with the given index.
+         * @param index index of the string in the table.
+         * @return      std::string_view view of the string, valid for the lifetime of the table.
+         * @throws      std::out_of_range if the index is not in the table.
+         */
+        std::string_view at(size_t index) const;
+
+        /**
+         * @brief       Method contains checks whether an index is in the table.
+         * @param index index of the string.
+         * @return      true if the index is in the table.
+         */
+        bool contains(size_t index) const { return index < spans.size(); }
+
+        /**
+         * @brief       Method buildViews creates a view of every string so cells can point at their text directly.
+         * @note        The views are only valid once the table is complete, so this must be called after finish.
+         */
+        void buildViews();
+
+        /**
+         * @brief   Method hasViews checks whether buildViews has been called for the table.
+         * @return  true if the strings can be resolved.
+         */
+        bool hasViews() const { return !views.empty() || spans.empty(); }
+
+        /**
+         * @brief       Method resolve retrieves the view of the string with the given index.
+         * @param index index of the string in the table.
+         * @return      const std::string_view* view of the string valid for the lifetime of the table, or nullptr if
+         *              the index is not in the table or the views have not been built.
+         */
+        const std::string_view *resolve(size_t index) const { return index < views.size() ? &views[index] : nullptr; }
+
+        /**
+         * @brief   Method size retrieves the number of strings in the table.
+         * @return  size_t number of strings.
+         */
+        size_t size() const { return spans.size(); }
+
+        /**
+         * @brief   Method getArenaSize retrieves the number of characters stored in the arena.
+         * @return  size_t number of characters, which is less than the total length of the strings when strings
+         *          have been interned.
+         */
+        size_t getArenaSize() const { return arena.size(); }
+
+        /**
+         * @brief   Method getMemoryUsage retrieves the number of bytes allocated for the arena and string locations.
+         * @return  size_t bytes allocated by the table.
+         */
+        size_t getMemoryUsage() const { return arena.capacity() + spans.capacity() * sizeof(span_t) + views.capacity() * sizeof(std::string_view); }
+
+    private:
+        friend class WorkbookCache;
+
+        /**
+         * @brief Structural representation of the location of a string in the arena.
+         */
+        struct span_t
+        {
+            uint64_t offset;
+            uint32_t length;
+        };
+
+        /**
+         * @brief Structural representation of a slot of the intern table, holding the first index of a string.
+         */
+        struct intern_slot_t
+        {
+            uint32_t index;
+            uint32_t hash;
+        };
+
+        /// Index marking a slot of the intern table that holds no string.
+        static constexpr uint32_t empty_slot = UINT32_MAX;
+
+        /**
+         * @brief   Method growInternSlots doubles the number of slots of the intern table and reinserts its strings.
+         */
+        void growInternSlots();
+
+        /// Characters of all the strings stored back to back.
+        std::string arena;
+        /// Location of each string in the arena indexed by string index.
+        std::vector<span_t> spans;
+        /// View of each string indexed by string index, only built when cells are to point at their text.
+        std::vector<std::string_view> views;
+        /// Open addressing table of the distinct strings, a power of two in size and only used while building the table.
+        std::vector<intern_slot_t> intern_slots;
+        /// Number of slots of the intern table holding a string.
+        size_t interned = 0;
+    };
+}
+
+#endif /* SharedStringTable_HPP */
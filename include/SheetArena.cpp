@@ -0,0 +1,47 @@
+#include "SheetArena.hpp"
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+SheetArena &SheetArena::createChild()
+{
+	children.push_back(std::make_unique<SheetArena>());
+	children.back()->root = root;
+	return *children.back();
+}
+
+sheet &SheetArena::getSheet()
+{
+	if (contents == nullptr)
+	{
+		contents = new (allocate(sizeof(sheet), alignof(sheet))) sheet(this);
+	}
+	return *contents;
+}
+
+size_t SheetArena::getAllocatedBytes() const
+{
+	size_t bytes = allocated_bytes;
+	for (auto &child : children)
+	{
+		bytes += child->getAllocatedBytes();
+	}
+	return bytes;
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+void *SheetArena::do_allocate(size_t bytes, size_t alignment)
+{
+	allocated_bytes += bytes;
+	return arena.allocate(bytes, alignment);
+}
+
+bool SheetArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+	const SheetArena *other_arena = dynamic_cast<const SheetArena *>(&other);
+	return other_arena != nullptr && other_arena->root == root;
+}
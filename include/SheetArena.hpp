@@ -0,0 +1,95 @@
+/**
+ * @file    SheetArena.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the SheetArena, the memory that holds the rows and cells of a sheet.
+ * @details Every node and cell array of a sheet is allocated from its arena, which hands out memory from a few large
+ *          blocks and never frees anything individually. Releasing a sheet frees the blocks of its arena without
+ *          visiting any of its rows.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef SheetArena_HPP
+#define SheetArena_HPP
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "ExcelTypes.hpp"
+
+namespace excel_parser
+{
+    /**
+     * @brief   Class SheetArena is a monotonic memory resource holding a single sheet.
+     * @details An arena is not thread safe, so a sheet that is parsed by several threads gives each thread a child
+     *          arena. Children compare equal to their parent, so the rows they hold can be spliced into the sheet of
+     *          the parent, and they are freed along with it.
+     */
+    class SheetArena : public std::pmr::memory_resource
+    {
+    public:
+        /**
+         * @brief               Constructor for the SheetArena class.
+         * @param block_size    size in bytes of the first block, later blocks grow geometrically.
+         */
+        explicit SheetArena(size_t block_size = 64 * 1024) : root(this), arena(block_size), allocated_bytes(0), contents(nullptr) {}
+
+        SheetArena(const SheetArena &) = delete;
+        void operator=(const SheetArena &) = delete;
+
+        /**
+         * @brief   Method createChild creates an arena that is owned by this one and compares equal to it.
+         * @return  SheetArena& the child, which may be used by another thread but must not outlive this arena.
+         * @note    Must not be called while another thread is using this arena.
+         */
+        SheetArena &createChild();
+
+        /**
+         * @brief   Method getSheet retrieves the sheet held by the arena, creating it in the arena on the first call.
+         * @return  sheet& the sheet, whose destructor is never run as its memory is freed with the arena.
+         */
+        sheet &getSheet();
+
+        /**
+         * @brief           Method share creates a handle to the sheet held by an arena.
+         * @param arena     arena holding the sheet, which is kept alive for as long as the handle is held.
+         * @return          sheet_handle handle to the sheet.
+         */
+        static sheet_handle share(const std::shared_ptr<SheetArena> &arena) { return sheet_handle(arena, &arena->getSheet()); }
+
+        /**
+         * @brief   Method getAllocatedBytes retrieves the number of bytes handed out by the arena and its children.
+         * @return  size_t number of bytes allocated.
+         */
+        size_t getAllocatedBytes() const;
+
+        /**
+         * @brief           Method retain keeps an object alive for as long as the arena, such as the shared strings the
+         *                  cells of the sheet point at.
+         * @param owner     handle to the object.
+         */
+        void retain(std::shared_ptr<const void> owner) { retained.push_back(std::move(owner)); }
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+        /// Arena at the top of the family of this arena.
+        SheetArena *root;
+        /// Resource that the blocks of the arena are allocated from.
+        std::pmr::monotonic_buffer_resource arena;
+        /// Children of the arena.
+        std::vector<std::unique_ptr<SheetArena>> children;
+        /// Number of bytes handed out by the arena.
+        size_t allocated_bytes;
+        /// Sheet held by the arena, if it has been created.
+        sheet *contents;
+        /// Objects kept alive for as long as the arena.
+        std::vector<std::shared_ptr<const void>> retained;
+    };
+}
+
+#endif /* SheetArena_HPP */
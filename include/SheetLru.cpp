@@ -0,0 +1,101 @@
+#include "SheetLru.hpp"
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+std::vector<SheetLru::sheet_key> SheetLru::setBudget(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.budget = bytes;
+	return evict(nullptr);
+}
+
+std::vector<SheetLru::sheet_key> SheetLru::insert(const std::string &file_name, const std::string &sheet_name, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	sheet_key key(file_name, sheet_name);
+	auto it = entries.find(key);
+	if (it != entries.end())
+	{
+		stats.usage -= it->second.bytes;
+		order.erase(it->second.position);
+		entries.erase(it);
+	}
+	order.push_front(key);
+	entries.emplace(key, entry_t{order.begin(), bytes});
+	stats.usage += bytes;
+	return evict(&key);
+}
+
+void SheetLru::touch(const std::string &file_name, const std::string &sheet_name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	++stats.hits;
+	auto it = entries.find(std::make_pair(std::string_view(file_name), std::string_view(sheet_name)));
+	if (it != entries.end())
+	{
+		order.splice(order.begin(), order, it->second.position);
+	}
+}
+
+void SheetLru::recordMiss()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	++stats.misses;
+}
+
+void SheetLru::erase(const std::string &file_name, const std::string &sheet_name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = entries.find(std::make_pair(std::string_view(file_name), std::string_view(sheet_name)));
+	if (it != entries.end())
+	{
+		stats.usage -= it->second.bytes;
+		order.erase(it->second.position);
+		entries.erase(it);
+	}
+}
+
+void SheetLru::eraseFile(const std::string &file_name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = entries.lower_bound(sheet_key(file_name, std::string()));
+	while (it != entries.end() && it->first.first == file_name)
+	{
+		stats.usage -= it->second.bytes;
+		order.erase(it->second.position);
+		it = entries.erase(it);
+	}
+}
+
+cache_stats_t SheetLru::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+std::vector<SheetLru::sheet_key> SheetLru::evict(const sheet_key *keep)
+{
+	std::vector<sheet_key> evicted;
+	while (stats.budget != 0 && stats.usage > stats.budget && !order.empty())
+	{
+		sheet_key key = order.back();
+		if (keep != nullptr && key == *keep)
+		{
+			// Only the sheet being inserted is left, which stays loaded even though it is over the budget.
+			break;
+		}
+		auto it = entries.find(key);
+		stats.usage -= it->second.bytes;
+		entries.erase(it);
+		order.pop_back();
+		++stats.evictions;
+		evicted.push_back(std::move(key));
+	}
+	return evicted;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file    SheetLru.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the SheetLru, which tracks the memory used by loaded sheets.
+ * @details The SheetLru records the estimated size of every sheet the ExcelParser holds in order of use, and picks
+ *          the least recently used sheets to be evicted whenever the total exceeds a memory budget.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef SheetLru_HPP
+#define SheetLru_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace excel_parser
+{
+    /**
+     * @brief Structural representation of the counters of the memory budget of the ExcelParser.
+     */
+    struct cache_stats_t
+    {
+        /// Memory budget in bytes, 0 if unlimited.
+        size_t budget = 0;
+        /// Estimated bytes used by the sheets that are loaded and the columnar sheets and indexes built from them.
+        size_t usage = 0;
+        /// Number of requests for a sheet that was already loaded.
+        uint64_t hits = 0;
+        /// Number of requests for a sheet that had to be read from its file.
+        uint64_t misses = 0;
+        /// Number of sheets evicted to stay within the budget.
+        uint64_t evictions = 0;
+    };
+
+    /**
+     * @brief   Class SheetLru keeps the loaded sheets in order of use and chooses which to evict.
+     * @note    The class is thread-safe. It only chooses the sheets to be evicted, releasing them is left to the
+     *          caller.
+     */
+    class SheetLru
+    {
+    public:
+        /**
+         * @brief   Type definition of the file name and sheet name identifying a sheet.
+         */
+        using sheet_key = std::pair<std::string, std::string>;
+
+        /**
+         * @brief           Method setBudget changes the memory budget.
+         * @param bytes     budget in bytes, 0 for unlimited.
+         * @return          std::vector<sheet_key> sheets to be evicted to stay within the new budget.
+         */
+        std::vector<sheet_key> setBudget(size_t bytes);
+
+        /**
+         * @brief               Method insert records a sheet that has been loaded as the most recently used.
+         * @param file_name     string name of the file the sheet is in.
+         * @param sheet_name    string name of the sheet.
+         * @param bytes         estimated size of the sheet in bytes.
+         * @return              std::vector<sheet_key> sheets to be evicted to stay within the budget, which never
+         *                      includes the sheet that was inserted.
+         */
+        std::vector<sheet_key> insert(const std::string &file_name, const std::string &sheet_name, size_t bytes);
+
+        /**
+         * @brief               Method touch records a request for a loaded sheet, making it the most recently used.
+         * @param file_name     string name of the file the sheet is in.
+         * @param sheet_name    string name of the sheet.
+         */
+        void touch(const std::string &file_name, const std::string &sheet_name);
+
+        /**
+         * @brief   Method recordMiss records a request for a sheet that was not loaded.
+         */
+        void recordMiss();
+
+        /**
+         * @brief               Method erase forgets a sheet.
+         * @param file_name     string name of the file the sheet is in.
+         * @param sheet_name    string name of the sheet.
+         */
+        void erase(const std::string &file_name, const std::string &sheet_name);
+
+        /**
+         * @brief           Method eraseFile forgets every sheet of a file.
+         * @param file_name string name of the file.
+         */
+        void eraseFile(const std::string &file_name);
+
+        /**
+         * @brief   Method getStats retrieves the counters of the memory budget.
+         * @return  cache_stats_t current counters.
+         */
+        cache_stats_t getStats() const;
+
+    private:
+        /**
+         * @brief           Method evict removes least recently used sheets until the usage is within the budget.
+         * @param keep      sheet that must not be evicted, or nullptr.
+         * @return          std::vector<sheet_key> sheets that were removed.
+         * @note            The mutex must be held.
+         */
+        std::vector<sheet_key> evict(const sheet_key *keep);
+
+        /**
+         * @brief   Structural representation of the ordering of sheet keys, which also compares keys held as views so
+         *          that a sheet can be looked up without copying its names.
+         */
+        struct key_less_t
+        {
+            using is_transparent = void;
+
+            template <typename Left, typename Right>
+            bool operator()(const Left &left, const Right &right) const
+            {
+                int file_order = std::string_view(left.first).compare(right.first);
+                return file_order < 0 || (file_order == 0 && std::string_view(left.second) < std::string_view(right.second));
+            }
+        };
+
+        /**
+         * @brief Structural representation of a loaded sheet.
+         */
+        struct entry_t
+        {
+            /// Position of the sheet in the order of use.
+            std::list<sheet_key>::iterator position;
+            /// Estimated size of the sheet in bytes.
+            size_t bytes;
+        };
+
+        /// Sheets in order of use, with the most recently used at the front.
+        std::list<sheet_key> order;
+        /// Map of sheets to their entries.
+        std::map<sheet_key, entry_t, key_less_t> entries;
+        /// Counters of the memory budget.
+        cache_stats_t stats;
+        /// Mutex to control access to the order, entries, and counters.
+        mutable std::mutex mutex;
+    };
+}
+
+#endif /* SheetLru_HPP */
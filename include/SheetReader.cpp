@@ -0,0 +1,289 @@
+#include "SheetReader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "ColumnarSheet.hpp"
+#include "SimdScan.hpp"
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+SheetReader::SheetReader(XmlStreamReader &sheet_reader, projection_t projection, bool fragment)
+	: sheet_reader(sheet_reader), projection(std::move(projection)), shared_strings(nullptr), text_resource(&row_text), row_id(0), in_sheet_data(fragment), finished(false)
+{
+	buildColumnMask();
+}
+
+SheetReader::SheetReader(std::unique_ptr<WorkbookArchive> archive, zip_file *file, projection_t projection)
+	: archive(std::move(archive)),
+	  source(std::make_unique<ZipEntrySource>(file)),
+	  owned_reader(std::make_unique<XmlStreamReader>(*source, this->archive->getBuffer())),
+	  sheet_reader(*owned_reader),
+	  projection(std::move(projection)),
+	  shared_strings(nullptr),
+	  text_resource(&row_text),
+	  row_id(0),
+	  in_sheet_data(false),
+	  finished(false)
+{
+	buildColumnMask();
+}
+
+bool SheetReader::next()
+{
+	if (finished)
+	{
+		return false;
+	}
+
+	for (XmlEvent event = sheet_reader.next(); event != END_DOCUMENT; event = sheet_reader.next())
+	{
+		if (event == START_ELEMENT)
+		{
+			std::string_view name = sheet_reader.name();
+			if (!in_sheet_data)
+			{
+				in_sheet_data = name == "sheetData";
+			}
+			else if (name == "row")
+			{
+				// Rows may omit their number, in which case they follow on from the previous row.
+				std::string_view attribute;
+				current_row.clear();
+				if (text_resource == &row_text)
+				{
+					row_text.release();
+				}
+				int number = row_id + 1;
+				if (sheet_reader.attribute("r", attribute))
+				{
+					std::from_chars(attribute.data(), attribute.data() + attribute.size(), number);
+				}
+				row_id = number;
+
+				// Rows are stored in order, so nothing after a row past the projection needs to be inflated.
+				if (row_id > projection.last_row)
+				{
+					break;
+				}
+				if (row_id < projection.first_row)
+				{
+					sheet_reader.skipElement();
+				}
+			}
+			else if (name == "c")
+			{
+				readCell();
+			}
+		}
+		else if (event == END_ELEMENT)
+		{
+			std::string_view name = sheet_reader.name();
+			if (!in_sheet_data)
+			{
+				continue;
+			}
+			else if (name == "row")
+			{
+				return true;
+			}
+			else if (name == "sheetData")
+			{
+				break;
+			}
+		}
+	}
+	finished = true;
+	return false;
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+void SheetReader::buildColumnMask()
+{
+	// Flag the projected columns by index so each cell can be checked without comparing strings.
+	for (const std::string &column : projection.columns)
+	{
+		int column_index = columnIndex(column);
+		if (column_index >= 0)
+		{
+			column_mask.resize(std::max(column_mask.size(), static_cast<size_t>(column_index) + 1));
+			column_mask[column_index] = true;
+		}
+	}
+}
+
+const std::string_view *SheetReader::storeText(std::string_view text)
+{
+	// The view and its characters share one allocation, so a cell only needs a pointer to the view.
+	void *memory = text_resource->allocate(sizeof(std::string_view) + text.size(), alignof(std::string_view));
+	char *characters = static_cast<char *>(memory) + sizeof(std::string_view);
+	std::copy(text.begin(), text.end(), characters);
+	return new (memory) std::string_view(characters, text.size());
+}
+
+void SheetReader::readCell()
+{
+	std::string_view attribute;
+	if (!sheet_reader.attribute("r", attribute))
+	{
+		sheet_reader.skipElement();
+		return;
+	}
+	// The column letters lead the reference, so they are decoded in place without copying them out. Cells past
+	// column "XFD" are invalid.
+	size_t letters = 0;
+	while (letters < attribute.size() && isColumnLetter(attribute[letters]))
+	{
+		++letters;
+	}
+	int column_index = columnIndex(attribute.substr(0, letters));
+	if (column_index < 0)
+	{
+		sheet_reader.skipElement();
+		return;
+	}
+	if (!projection.columns.empty())
+	{
+		if (static_cast<size_t>(column_index) >= column_mask.size() || !column_mask[column_index])
+		{
+			sheet_reader.skipElement();
+			return;
+		}
+	}
+
+	// Numbers (including booleans) and shared strings are parsed from their value. Errors are kept as ERROR cells, and
+	// formula string results, inline strings, dates, and any other type as INLINE_STRING cells holding their text.
+	cell_t c;
+	if (!sheet_reader.attribute("t", attribute) || attribute == "n" || attribute == "b")
+	{
+		c.type = NUMBER;
+	}
+	else if (attribute == "s")
+	{
+		c.type = STRING;
+	}
+	else
+	{
+		c.type = attribute == "e" ? ERROR : INLINE_STRING;
+	}
+
+	// The text of an inline string is the concatenation of the text runs inside its "is" element.
+	bool in_value = false;
+	bool in_inline = false;
+	bool in_inline_text = false;
+	bool has_value = false;
+	int depth = 1;
+	while (depth > 0)
+	{
+		switch (sheet_reader.next())
+		{
+		case START_ELEMENT:
+			++depth;
+			if (depth == 2 && sheet_reader.name() == "v")
+			{
+				in_value = true;
+				value_text.clear();
+			}
+			else if (depth == 2 && sheet_reader.name() == "is" && c.type == INLINE_STRING)
+			{
+				in_inline = true;
+				value_text.clear();
+			}
+			else if (in_inline && sheet_reader.name() == "rPh")
+			{
+				// Phonetic hints are not part of the text.
+				sheet_reader.skipElement();
+				--depth;
+			}
+			else if (in_inline && sheet_reader.name() == "t")
+			{
+				in_inline_text = true;
+			}
+			break;
+		case TEXT:
+			if (in_value || in_inline_text)
+			{
+				value_text.append(sheet_reader.text());
+			}
+			break;
+		case END_ELEMENT:
+			--depth;
+			if (in_inline_text)
+			{
+				in_inline_text = false;
+			}
+			else if (depth == 1 && in_inline)
+			{
+				in_inline = false;
+				has_value = true;
+			}
+			else if (depth == 1 && in_value && c.type != NUMBER && c.type != STRING)
+			{
+				in_value = false;
+				has_value = true;
+			}
+			else if (depth == 1 && in_value)
+			{
+				// Parse the value once here so readers of the cell never have to.
+				in_value = false;
+				const char *first = value_text.data();
+				const char *last = value_text.data() + value_text.size();
+				while (first < last && std::isspace(static_cast<unsigned char>(*first)))
+				{
+					++first;
+				}
+				// Most values are plain integers, which are converted eight digits at a time before falling back
+				// to the general parser for decimals, exponents, and signs.
+				uint64_t digits;
+				bool integer = simd::parseDigits(first, last, digits);
+				if (c.type == NUMBER)
+				{
+					if (integer && digits <= (uint64_t(1) << 53))
+					{
+						c.number = static_cast<double>(digits);
+						has_value = true;
+					}
+					else
+					{
+						has_value = std::from_chars(first, last, c.number).ec == std::errc();
+					}
+				}
+				else if (integer)
+				{
+					c.string_index = static_cast<uint32_t>(digits);
+					has_value = digits <= UINT32_MAX;
+				}
+				else
+				{
+					has_value = std::from_chars(first, last, c.string_index).ec == std::errc();
+				}
+			}
+			break;
+		case END_DOCUMENT:
+			throw std::runtime_error("[Excel Parser] (ERROR) Unexpected end of XML document inside a cell.");
+		}
+	}
+
+	// Cells without a value are skipped.
+	if (has_value)
+	{
+		if (c.type == STRING)
+		{
+			c.text = shared_strings == nullptr ? nullptr : shared_strings->resolve(c.string_index);
+		}
+		else if (c.type != NUMBER)
+		{
+			c = cell_t::makeText(c.type, storeText(value_text));
+		}
+		current_row.set(column_index, c);
+	}
+}
@@ -0,0 +1,139 @@
+/**
+ * @file    SheetReader.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the SheetReader, a cursor over the rows of a sheet of an Excel file.
+ * @details The SheetReader reads the rows of a sheet one at a time as the sheet file is inflated from its archive,
+ *          so a sheet of any size can be processed while only one row is held in memory.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef SheetReader_HPP
+#define SheetReader_HPP
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <zip.h>
+
+#include "ExcelTypes.hpp"
+#include "SharedStringTable.hpp"
+#include "WorkbookArchive.hpp"
+#include "XmlStreamReader.hpp"
+
+namespace excel_parser
+{
+    /**
+     * @brief   Class SheetReader is a forward only cursor over the rows of a sheet.
+     * @details Each call to next reads one row from the XML of the sheet into storage that is reused for every row.
+     *          Cells outside the projection are skipped, and reading stops at the first row after the projection.
+     */
+    class SheetReader
+    {
+    public:
+        /**
+         * @brief               Constructor for a SheetReader over the XML of a sheet.
+         * @param sheet_reader  reader positioned at the start of the XML of a sheet, which must outlive the cursor.
+         * @param projection    columns and rows of the sheet to be read.
+         * @param fragment      whether the XML is a run of rows from inside the sheet data rather than a whole sheet.
+         */
+        explicit SheetReader(XmlStreamReader &sheet_reader, projection_t projection = projection_t(), bool fragment = false);
+
+        /**
+         * @brief               Constructor for a SheetReader that owns the archive the sheet is inflated from.
+         * @param archive       archive of the Excel file, whose buffer is used for the window of the XML reader.
+         * @param file          libzip handle for the sheet file opened from the archive, which the cursor closes.
+         * @param projection    columns and rows of the sheet to be read.
+         */
+        SheetReader(std::unique_ptr<WorkbookArchive> archive, zip_file *file, projection_t projection = projection_t());
+
+        SheetReader(const SheetReader &) = delete;
+        void operator=(const SheetReader &) = delete;
+
+        /**
+         * @brief   Method next advances the cursor to the next row of the sheet.
+         * @return  true if a row was read, false once the end of the sheet or the projection is reached.
+         * @throws  std::runtime_error if the XML of the sheet is malformed or cannot be inflated.
+         */
+        bool next();
+
+        /**
+         * @brief   Method getRowId retrieves the number of the current row.
+         * @return  int number of the row read by the last successful call to next.
+         */
+        int getRowId() const { return row_id; }
+
+        /**
+         * @brief   Method getRow retrieves the cells of the current row.
+         * @return  const row& cells of the row read by the last successful call to next, which are only valid until
+         *          next is called again.
+         */
+        const row &getRow() const { return current_row; }
+
+        /**
+         * @brief                   Method setSharedStrings resolves the STRING cells read from now on to their text.
+         * @param shared_strings    shared strings of the file with their views built, which must outlive the rows,
+         *                          or nullptr to leave the cells unresolved.
+         */
+        void setSharedStrings(const SharedStringTable *shared_strings) { this->shared_strings = shared_strings; }
+
+        /**
+         * @brief           Method setTextResource stores the text of the INLINE_STRING and ERROR cells read from now on
+         *                  in a memory resource, so the cells stay valid after the cursor moves on.
+         * @param resource  resource for the text, such as the memory of the sheet the rows are copied into, which must
+         *                  outlive the rows. By default the text is only valid until next is called again.
+         */
+        void setTextResource(std::pmr::memory_resource *resource) { text_resource = resource; }
+
+    private:
+        /**
+         * @brief   Method buildColumnMask flags the columns of the projection by column index.
+         */
+        void buildColumnMask();
+
+        /**
+         * @brief   Method readCell reads the cell at the current START_ELEMENT into the current row.
+         */
+        void readCell();
+
+        /**
+         * @brief       Method storeText copies the text of a INLINE_STRING or ERROR cell into the text resource.
+         * @param text  text of the cell.
+         * @return      const std::string_view* view of the copy, allocated along with it.
+         */
+        const std::string_view *storeText(std::string_view text);
+
+        /// Archive the sheet is inflated from, if the cursor owns it.
+        std::unique_ptr<WorkbookArchive> archive;
+        /// Source inflating the sheet file, if the cursor owns it.
+        std::unique_ptr<ZipEntrySource> source;
+        /// Reader of the XML of the sheet, if the cursor owns it.
+        std::unique_ptr<XmlStreamReader> owned_reader;
+        /// Reader of the XML of the sheet.
+        XmlStreamReader &sheet_reader;
+        /// Columns and rows of the sheet to be read.
+        projection_t projection;
+        /// Flags of the projected columns by column index, empty if every column is read.
+        std::vector<bool> column_mask;
+        /// Shared strings the STRING cells are resolved to, if any.
+        const SharedStringTable *shared_strings;
+        /// Text of the INLINE_STRING and ERROR cells of the current row, released when the next row is read.
+        std::pmr::monotonic_buffer_resource row_text;
+        /// Resource the text of the INLINE_STRING and ERROR cells is stored in.
+        std::pmr::memory_resource *text_resource;
+        /// Number of the current row.
+        int row_id;
+        /// Cells of the current row.
+        row current_row;
+        /// Whether the start of the sheet data has been reached.
+        bool in_sheet_data;
+        /// Whether the end of the sheet data or the projection has been reached.
+        bool finished;
+        /// Storage reused for the text of the value of each cell.
+        std::string value_text;
+    };
+}
+
+#endif /* SheetReader_HPP */
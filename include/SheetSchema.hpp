@@ -0,0 +1,189 @@
+/**
+ * @file    SheetSchema.hpp
+ * @author  James Horner
+ * @brief   This file contains the templates used to describe the fixed columns of a sheet at compile time, so that
+ *          ExcelParser::readSheetAs can read its rows straight into structures.
+ * @details A schema lists the column of each member of a record structure. The columns read, the cell each member is
+ *          taken from, and the conversion of the cell to the type of the member are all resolved when compiling, so
+ *          reading a row only looks up each column and assigns its value.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef SheetSchema_HPP
+#define SheetSchema_HPP
+
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "CellReference.hpp"
+#include "ExcelTypes.hpp"
+
+namespace excel_parser
+{
+    /**
+     * @brief               Function columnOf converts Excel column letters into a 0 based column index at compile time.
+     * @param column_name   upper case column letters (e.g. "A" or "AB").
+     * @return              int index of the column ("A" is 0), or -1 if the name is empty, holds anything other
+     *                      than upper case letters, or is past column "XFD".
+     */
+    constexpr int columnOf(std::string_view column_name)
+    {
+        return column_name.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZ") == std::string_view::npos ? columnIndex(column_name) : -1;
+    }
+
+    namespace schema_detail
+    {
+        /**
+         * @brief   Structure member_traits splits a pointer to a data member into its class and member types.
+         */
+        template <typename Member>
+        struct member_traits;
+
+        template <typename Class, typename Value>
+        struct member_traits<Value Class::*>
+        {
+            using class_type = Class;
+            using value_type = Value;
+        };
+
+        template <typename T>
+        struct is_optional : std::false_type
+        {
+        };
+
+        template <typename T>
+        struct is_optional<std::optional<T>> : std::true_type
+        {
+        };
+
+        /**
+         * @brief   Structure is_text checks whether a member is read from the text of a STRING or INLINE_STRING cell.
+         */
+        template <typename T>
+        struct is_text : std::is_same<T, std::string>
+        {
+        };
+
+        template <typename T>
+        struct is_text<std::optional<T>> : is_text<T>
+        {
+        };
+
+        /**
+         * @brief       Function assign converts a cell to the type of a member.
+         * @param c     cell to be converted, or nullptr if the column holds no cell.
+         * @param value member to be assigned.
+         * @return      true if the cell held a value of the type of the member, otherwise the member is unchanged.
+         */
+        template <typename T>
+        bool assign(const cell_t *c, T &value)
+        {
+            if constexpr (is_optional<T>::value)
+            {
+                typename T::value_type inner{};
+                if (assign(c, inner))
+                {
+                    value = std::move(inner);
+                    return true;
+                }
+                value.reset();
+                return false;
+            }
+            else if constexpr (std::is_same<T, std::string>::value)
+            {
+                if (c == nullptr || c->type == ERROR || !c->hasText())
+                {
+                    return false;
+                }
+                value.assign(c->getText());
+                return true;
+            }
+            else if constexpr (std::is_arithmetic<T>::value)
+            {
+                if (c == nullptr || c->type != NUMBER)
+                {
+                    return false;
+                }
+                if constexpr (std::is_same<T, bool>::value)
+                {
+                    value = c->getNumber() != 0;
+                }
+                else
+                {
+                    value = static_cast<T>(c->getNumber());
+                }
+                return true;
+            }
+            else
+            {
+                static_assert(!sizeof(T), "Schema members must be arithmetic, std::string, or std::optional of either.");
+            }
+        }
+    }
+
+    /**
+     * @brief   Structure field_t maps a column of a sheet to a member of a record structure.
+     * @details Members may be arithmetic, read from NUMBER cells, or std::string, read from the text of STRING and
+     *          INLINE_STRING cells.
+     *          Either may be wrapped in std::optional, which is empty when the cell is missing or holds the other type,
+     *          whereas members that are not optional keep the value they were initialised with.
+     */
+    template <int ColumnIndex, auto Member>
+    struct field_t
+    {
+        static_assert(ColumnIndex >= 0, "Schema columns must be upper case Excel column letters.");
+
+        /// Record structure the member belongs to.
+        using record_type = typename schema_detail::member_traits<decltype(Member)>::class_type;
+        /// Type of the member.
+        using value_type = typename schema_detail::member_traits<decltype(Member)>::value_type;
+        /// 0 based index of the column the member is read from.
+        static constexpr int column_index = ColumnIndex;
+        /// Whether the member needs the text of the shared strings.
+        static constexpr bool reads_text = schema_detail::is_text<value_type>::value;
+
+        /**
+         * @brief           Method read assigns the member from its cell of a row.
+         * @param r         row to be read.
+         * @param record    record to be assigned.
+         */
+        static void read(const row &r, record_type &record) { schema_detail::assign(r.find(ColumnIndex), record.*Member); }
+    };
+
+    /**
+     * @brief   Structure schema_t describes the columns of a sheet read into a record structure.
+     * @details For example, a sheet with prices in column A and names in column C can be read with
+     *          schema_t<item_t, field_t<columnOf("A"), &item_t::price>, field_t<columnOf("C"), &item_t::name>>.
+     */
+    template <typename Record, typename... Fields>
+    struct schema_t
+    {
+        static_assert(sizeof...(Fields) > 0, "Schemas must have at least one field.");
+        static_assert((std::is_same<Record, typename Fields::record_type>::value && ...), "Schema fields must be members of the record.");
+        static_assert(std::is_default_constructible<Record>::value, "Schema records must be default constructible.");
+
+        /// Record structure each row is read into.
+        using record_type = Record;
+        /// Whether any member needs the text of the shared strings.
+        static constexpr bool reads_text = (Fields::reads_text || ...);
+
+        /**
+         * @brief   Method columns retrieves the letters of the columns of the schema.
+         * @return  std::set<std::string> letters of the columns, used to project the sheet.
+         */
+        static std::set<std::string> columns() { return {columnName(Fields::column_index)...}; }
+
+        /**
+         * @brief           Method read assigns every member of a record from a row.
+         * @param r         row to be read.
+         * @param record    record to be assigned.
+         */
+        static void read(const row &r, Record &record) { (Fields::read(r, record), ...); }
+    };
+}
+
+#endif /* SheetSchema_HPP */
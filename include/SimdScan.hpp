@@ -0,0 +1,185 @@
+/**
+ * @file    SimdScan.hpp
+ * @author  James Horner
+ * @brief   This file contains the vectorised scanning routines used to tokenise the XML parts of Excel files.
+ * @details The routines compare 32 bytes at a time with AVX2, 16 bytes at a time with SSE2 or NEON, and fall back to
+ *          a scalar loop elsewhere. The instruction set is chosen when compiling, so building with the NATIVE option
+ *          (or an equivalent -m flag) is required to use AVX2.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef SimdScan_HPP
+#define SimdScan_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace excel_parser
+{
+    namespace simd
+    {
+        /**
+         * @brief       Function countTrailingZeros finds the index of the lowest set bit of a mask.
+         * @param mask  non zero mask.
+         * @return      unsigned int index of the lowest set bit.
+         */
+        inline unsigned int countTrailingZeros(uint64_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return static_cast<unsigned int>(index);
+#else
+            return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif
+        }
+
+        /**
+         * @brief       Function countSetBits counts the set bits of a mask.
+         * @param mask  mask to be counted.
+         * @return      unsigned int number of set bits.
+         */
+        inline unsigned int countSetBits(uint64_t mask)
+        {
+#if defined(_MSC_VER)
+            return static_cast<unsigned int>(__popcnt64(mask));
+#else
+            return static_cast<unsigned int>(__builtin_popcountll(mask));
+#endif
+        }
+
+        /**
+         * @brief       Function findAny searches a block of memory for the first of three characters.
+         * @param data  pointer to the first byte of the memory.
+         * @param size  number of bytes to search.
+         * @param a     first character to search for.
+         * @param b     second character to search for.
+         * @param c     third character to search for.
+         * @return      size_t offset of the first matching character, or size if there is none.
+         */
+        inline size_t findAny(const char *data, size_t size, char a, char b, char c)
+        {
+            size_t i = 0;
+#if defined(__AVX2__)
+            const __m256i wide_a = _mm256_set1_epi8(a);
+            const __m256i wide_b = _mm256_set1_epi8(b);
+            const __m256i wide_c = _mm256_set1_epi8(c);
+            for (; i + 32 <= size; i += 32)
+            {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                __m256i matches = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, wide_a), _mm256_cmpeq_epi8(chunk, wide_b)),
+                                                  _mm256_cmpeq_epi8(chunk, wide_c));
+                uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(matches));
+                if (mask != 0)
+                {
+                    return i + countTrailingZeros(mask);
+                }
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            const __m128i wide_a = _mm_set1_epi8(a);
+            const __m128i wide_b = _mm_set1_epi8(b);
+            const __m128i wide_c = _mm_set1_epi8(c);
+            for (; i + 16 <= size; i += 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, wide_a), _mm_cmpeq_epi8(chunk, wide_b)),
+                                               _mm_cmpeq_epi8(chunk, wide_c));
+                uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(matches));
+                if (mask != 0)
+                {
+                    return i + countTrailingZeros(mask);
+                }
+            }
+#elif defined(__ARM_NEON)
+            const uint8x16_t wide_a = vdupq_n_u8(static_cast<uint8_t>(a));
+            const uint8x16_t wide_b = vdupq_n_u8(static_cast<uint8_t>(b));
+            const uint8x16_t wide_c = vdupq_n_u8(static_cast<uint8_t>(c));
+            for (; i + 16 <= size; i += 16)
+            {
+                uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t *>(data + i));
+                uint8x16_t matches = vorrq_u8(vorrq_u8(vceqq_u8(chunk, wide_a), vceqq_u8(chunk, wide_b)), vceqq_u8(chunk, wide_c));
+                // Narrowing each 16 bit lane by 4 bits leaves a nibble per byte, as NEON has no movemask.
+                uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+                if (mask != 0)
+                {
+                    return i + (countTrailingZeros(mask) >> 2);
+                }
+            }
+#endif
+            for (; i < size; ++i)
+            {
+                if (data[i] == a || data[i] == b || data[i] == c)
+                {
+                    return i;
+                }
+            }
+            return size;
+        }
+
+        /**
+         * @brief           Function parseDigits converts a run of up to 19 decimal digits into an integer, eight
+         *                  digits at a time.
+         * @param first     pointer to the first character.
+         * @param last      pointer one past the last character.
+         * @param value     set to the value of the digits on success.
+         * @return          true if [first, last) is between 1 and 19 digits and nothing else.
+         */
+        inline bool parseDigits(const char *first, const char *last, uint64_t &value)
+        {
+            size_t length = static_cast<size_t>(last - first);
+            if (length == 0 || length > 19)
+            {
+                return false;
+            }
+            uint64_t result = 0;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            while (length >= 8)
+            {
+                uint64_t chunk;
+                std::memcpy(&chunk, first, 8);
+                // Every byte must be in '0' to '9': subtracting '0' must not borrow and adding 6 must not carry.
+                uint64_t digits = chunk - 0x3030303030303030ULL;
+                if (((digits | (digits + 0x0606060606060606ULL)) & 0xF0F0F0F0F0F0F0F0ULL) != 0)
+                {
+                    return false;
+                }
+                // Combine pairs of digits, then pairs of pairs, then the two halves. The memory is read little
+                // endian, so the first digit is in the lowest byte.
+                digits = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFULL;
+                digits = (digits * 100 + (digits >> 16)) & 0x0000FFFF0000FFFFULL;
+                digits = (digits * 10000 + (digits >> 32)) & 0x00000000FFFFFFFFULL;
+                result = result * 100000000ULL + digits;
+                first += 8;
+                length -= 8;
+            }
+#endif
+            for (; length > 0; --length, ++first)
+            {
+                unsigned int digit = static_cast<unsigned char>(*first) - '0';
+                if (digit > 9)
+                {
+                    return false;
+                }
+                result = result * 10 + digit;
+            }
+            value = result;
+            return true;
+        }
+    }
+}
+
+#endif /* SimdScan_HPP */
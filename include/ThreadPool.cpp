@@ -0,0 +1,112 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+using namespace excel_parser;
+
+thread_local ThreadPool *ThreadPool::current_pool = nullptr;
+thread_local size_t ThreadPool::current_index = 0;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+ThreadPool::ThreadPool(unsigned int threads) : next_queue(0), pending(0), stopping(false)
+{
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (unsigned int i = 0; i < threads; ++i)
+	{
+		queues.emplace_back(std::make_unique<worker_queue_t>());
+	}
+	for (unsigned int i = 0; i < threads; ++i)
+	{
+		workers.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		stopping = true;
+	}
+	pending_condition.notify_all();
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+void ThreadPool::push(std::function<void()> task)
+{
+	// Count the task before it is visible so a worker can never take it while the count is still zero.
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex);
+		++pending;
+	}
+	size_t index = current_pool == this ? current_index : next_queue++ % queues.size();
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	pending_condition.notify_one();
+}
+
+bool ThreadPool::pop(size_t index, std::function<void()> &task)
+{
+	// Run the newest of our own tasks first while its data is likely still in cache.
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		if (!queues[index]->tasks.empty())
+		{
+			task = std::move(queues[index]->tasks.back());
+			queues[index]->tasks.pop_back();
+			return true;
+		}
+	}
+	// Otherwise steal the oldest task of another worker, leaving it the tasks it queued most recently.
+	for (size_t i = 1; i < queues.size(); ++i)
+	{
+		worker_queue_t &victim = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::work(size_t index)
+{
+	current_pool = this;
+	current_index = index;
+	for (;;)
+	{
+		std::function<void()> task;
+		if (pop(index, task))
+		{
+			{
+				std::lock_guard<std::mutex> lock(pending_mutex);
+				--pending;
+			}
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(pending_mutex);
+		pending_condition.wait(lock, [this]()
+							   { return stopping || pending > 0; });
+		if (pending == 0)
+		{
+			return;
+		}
+	}
+}
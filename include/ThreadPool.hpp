@@ -0,0 +1,126 @@
+/**
+ * @file    ThreadPool.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the ThreadPool used to parse Excel files concurrently.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef ThreadPool_HPP
+#define ThreadPool_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace excel_parser
+{
+    /**
+     * @brief   Class ThreadPool runs submitted tasks on a fixed number of worker threads.
+     * @details Every worker has its own queue of tasks. Tasks submitted from outside the pool are spread across the
+     *          queues in turn, and tasks submitted by a worker go onto its own queue. Workers take the newest task
+     *          from their own queue and, once it is empty, steal the oldest task from the queues of the other
+     *          workers, so no worker sits idle while any task is waiting. Destroying the pool waits for every
+     *          submitted task to finish before the workers are joined.
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * @brief           Constructor for the ThreadPool class.
+         * @param threads   number of worker threads, 0 uses the number of hardware threads.
+         */
+        explicit ThreadPool(unsigned int threads);
+
+        /**
+         * @brief   Destructor for the ThreadPool class which finishes all submitted tasks then joins the workers.
+         */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        void operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief       Method submit queues a task to be run by one of the workers.
+         * @param task  callable object taking no arguments.
+         * @return      std::future holding the result of the task, or the exception it threw.
+         */
+        template <typename Task>
+        std::future<typename std::invoke_result<Task>::type> submit(Task task)
+        {
+            using result_type = typename std::invoke_result<Task>::type;
+            auto packaged = std::make_shared<std::packaged_task<result_type()>>(std::move(task));
+            std::future<result_type> result = packaged->get_future();
+            push([packaged]()
+                 { (*packaged)(); });
+            return result;
+        }
+
+        /**
+         * @brief   Method size retrieves the number of worker threads in the pool.
+         * @return  unsigned int number of workers.
+         */
+        unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+
+    private:
+        /**
+         * @brief   Structural representation of the queue of tasks belonging to a worker.
+         */
+        struct worker_queue_t
+        {
+            /// Tasks waiting to be run, with the newest at the back.
+            std::deque<std::function<void()>> tasks;
+            /// Mutex to control access to the tasks.
+            std::mutex mutex;
+        };
+
+        /**
+         * @brief       Method push adds a task to a queue and wakes a worker to run it.
+         * @param task  task to be queued.
+         */
+        void push(std::function<void()> task);
+
+        /**
+         * @brief           Method pop takes a task from the queue of a worker, or steals one from another worker.
+         * @param index     index of the worker.
+         * @param task      function set to the task that was taken.
+         * @return          true if a task was taken, false if every queue was empty.
+         */
+        bool pop(size_t index, std::function<void()> &task);
+
+        /**
+         * @brief           Method work is run by each worker to take tasks from the queues until the pool is destroyed.
+         * @param index     index of the worker.
+         */
+        void work(size_t index);
+
+        /// Worker threads of the pool.
+        std::vector<std::thread> workers;
+        /// Queue of tasks of each worker.
+        std::vector<std::unique_ptr<worker_queue_t>> queues;
+        /// Index of the queue the next task submitted from outside the pool is added to.
+        std::atomic<size_t> next_queue;
+        /// Number of tasks queued but not yet taken by a worker.
+        size_t pending;
+        /// Mutex to control access to the pending count and stopping flag.
+        std::mutex pending_mutex;
+        /// Condition signalled when a task is queued or the pool is stopping.
+        std::condition_variable pending_condition;
+        /// Whether the pool is being destroyed.
+        bool stopping;
+
+        /// Pool that the current thread is a worker of, if any.
+        static thread_local ThreadPool *current_pool;
+        /// Index of the current thread in the pool it is a worker of.
+        static thread_local size_t current_index;
+    };
+}
+
+#endif /* ThreadPool_HPP */
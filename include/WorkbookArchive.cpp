@@ -0,0 +1,110 @@
+#include "WorkbookArchive.hpp"
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+WorkbookArchive::WorkbookArchive(std::string file_name, bool memory_map)
+	: file_name(file_name), data(nullptr), size(0), from_memory(false), book(nullptr), read_ahead(false)
+{
+	if (memory_map)
+	{
+		mapping = std::make_unique<MappedFile>(file_name);
+		data = mapping->getData();
+		size = mapping->getSize();
+	}
+	book = openBook();
+}
+
+WorkbookArchive::WorkbookArchive(std::string file_name, std::vector<char> contents)
+	: file_name(file_name), contents(std::move(contents)), size(0), from_memory(true), book(nullptr), read_ahead(false)
+{
+	// An empty buffer is not a zip archive, and reading it must not fall back to a file that happens to share its name.
+	if (this->contents.empty())
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error opening spreadsheet archive " + file_name + ": the buffer is empty";
+		throw std::runtime_error(error_message);
+	}
+	data = this->contents.data();
+	size = this->contents.size();
+	book = openBook();
+}
+
+WorkbookArchive::~WorkbookArchive()
+{
+	zip_close(book);
+}
+
+zip *WorkbookArchive::openBook() const
+{
+	if (!from_memory && mapping == nullptr)
+	{
+		int err = 0;
+		zip *b = zip_open(file_name.c_str(), ZIP_RDONLY, &err);
+		if (b == nullptr)
+		{
+			std::string error_message = "[Excel Parser] (ERROR) Error opening spreadsheet archive: " + std::to_string(err);
+			throw std::runtime_error(error_message);
+		}
+		return b;
+	}
+
+	// Read the archive straight out of memory, the source does not take ownership of the data.
+	zip_error_t error;
+	zip_error_init(&error);
+	zip_source_t *source = zip_source_buffer_create(data, size, 0, &error);
+	if (source == nullptr)
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error creating source for spreadsheet archive " + file_name + ": " + zip_error_strerror(&error);
+		zip_error_fini(&error);
+		throw std::runtime_error(error_message);
+	}
+	zip *b = zip_open_from_source(source, ZIP_RDONLY, &error);
+	if (b == nullptr)
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error opening spreadsheet archive " + file_name + ": " + zip_error_strerror(&error);
+		zip_source_free(source);
+		zip_error_fini(&error);
+		throw std::runtime_error(error_message);
+	}
+	zip_error_fini(&error);
+	return b;
+}
+
+std::string WorkbookArchive::getSheetPart(const std::string &sheet_name) const
+{
+	if (name_part_map.find(sheet_name) == name_part_map.end())
+	{
+		std::string error_message = "[Excel Parser] (ERROR) Error finding sheet with name \"" + sheet_name + "\" in file " + file_name;
+		throw std::runtime_error(error_message);
+	}
+	return name_part_map.at(sheet_name);
+}
+
+workbook_signature_t WorkbookArchive::readSignature()
+{
+	auto read_part = [this](const std::string &part_name)
+	{
+		part_signature_t signature;
+		signature.part_name = part_name;
+		struct zip_stat file_stat;
+		zip_stat_init(&file_stat);
+		if (zip_stat(book, part_name.c_str(), ZIP_FL_NODIR, &file_stat) == 0)
+		{
+			signature.crc = file_stat.crc;
+			signature.size = file_stat.size;
+			signature.valid = (file_stat.valid & ZIP_STAT_CRC) && (file_stat.valid & ZIP_STAT_SIZE);
+		}
+		return signature;
+	};
+
+	workbook_signature_t read_signature;
+	read_signature.shared_strings = read_part("sharedStrings.xml");
+	for (auto &name_part : name_part_map)
+	{
+		read_signature.sheets.emplace(name_part.first, read_part(name_part.second));
+	}
+	signature = read_signature;
+	return read_signature;
+}
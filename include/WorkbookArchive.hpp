@@ -0,0 +1,231 @@
+/**
+ * @file    WorkbookArchive.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the WorkbookArchive which keeps an Excel archive open for reading.
+ * @details The WorkbookArchive opens an Excel file with libzip either from its path, from a memory mapping of the
+ *          file, or from a buffer supplied by the caller. It is kept by files opened lazily, whose sheets are only
+ *          read from the archive the first time they are requested.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef WorkbookArchive_HPP
+#define WorkbookArchive_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <zip.h>
+
+#include "ExcelTypes.hpp"
+#include "MappedFile.hpp"
+
+namespace excel_parser
+{
+    /**
+     * @brief   Structural representation of the identity of a file in an Excel archive, taken from the central
+     *          directory of the archive without inflating the file.
+     */
+    struct part_signature_t
+    {
+        /// Name of the file in the archive.
+        std::string part_name;
+        /// CRC32 of the uncompressed contents of the file.
+        uint32_t crc = 0;
+        /// Uncompressed size of the file in bytes.
+        uint64_t size = 0;
+        /// Whether the archive recorded both the CRC32 and size of the file.
+        bool valid = false;
+
+        /**
+         * @brief       Method matches checks whether two signatures are known to be of the same contents.
+         * @param other signature to be compared with.
+         * @return      true if both signatures are valid and identical.
+         */
+        bool matches(const part_signature_t &other) const
+        {
+            return valid && other.valid && crc == other.crc && size == other.size && part_name == other.part_name;
+        }
+
+        /**
+         * @brief       Method differs checks whether two signatures are known to be of different contents.
+         * @param other signature to be compared with.
+         * @return      true if only one signature is valid or both are valid and not identical, false if neither is
+         *              valid, such as when the file is missing from both archives.
+         */
+        bool differs(const part_signature_t &other) const { return valid != other.valid || (valid && !matches(other)); }
+    };
+
+    /**
+     * @brief   Structural representation of the signatures of the files of an Excel archive that are parsed.
+     */
+    struct workbook_signature_t
+    {
+        /// Signature of the shared strings file.
+        part_signature_t shared_strings;
+        /// Map of sheet names to the signatures of their sheet files.
+        std::map<std::string, part_signature_t> sheets;
+    };
+
+    /**
+     * @brief   Class WorkbookArchive owns an open libzip handle for an Excel file and the index of its sheet files.
+     * @note    libzip handles are not thread-safe, so the mutex must be held while the handle is in use. Threads
+     *          that need to read concurrently can open handles of their own with openBook.
+     */
+    class WorkbookArchive
+    {
+    public:
+        /**
+         * @brief               Constructor for the WorkbookArchive class which opens the archive from a file.
+         * @param file_name     string name of the Excel file to be opened.
+         * @param memory_map    whether to map the file into memory and read it through a libzip buffer source,
+         *                      rather than having libzip read the file through the file system.
+         * @throws              std::runtime_error if the archive cannot be opened.
+         */
+        explicit WorkbookArchive(std::string file_name, bool memory_map = false);
+
+        /**
+         * @brief               Constructor for the WorkbookArchive class which opens the archive from memory.
+         * @param file_name     string name the Excel file is known by.
+         * @param contents      contents of the Excel file, which the archive takes ownership of.
+         * @throws              std::runtime_error if the contents are empty or the archive cannot be opened.
+         */
+        WorkbookArchive(std::string file_name, std::vector<char> contents);
+
+        /**
+         * @brief   Destructor for the WorkbookArchive class which closes the archive and releases its memory.
+         */
+        ~WorkbookArchive();
+
+        WorkbookArchive(const WorkbookArchive &) = delete;
+        void operator=(const WorkbookArchive &) = delete;
+
+        /**
+         * @brief   Method getBook retrieves the libzip handle for the archive.
+         * @return  zip* libzip handle, which must only be used while holding the mutex.
+         */
+        zip *getBook() { return book; }
+
+        /**
+         * @brief   Method getMutex retrieves the mutex guarding the libzip handle.
+         * @return  std::mutex& mutex to be held while the handle is in use.
+         */
+        std::mutex &getMutex() { return mutex; }
+
+        /**
+         * @brief   Method openBook opens an additional libzip handle for the archive that can be used by another thread.
+         * @return  zip* libzip handle, which the caller must close with zip_close before the archive is destroyed.
+         * @throws  std::runtime_error if the archive cannot be opened.
+         * @note    When the archive is in memory the new handle reads the same memory, so nothing is copied.
+         */
+        zip *openBook() const;
+
+        /**
+         * @brief   Method canReopen checks whether the archive can be opened again from its file.
+         * @return  true if the archive was opened from a file rather than a buffer supplied by the caller.
+         */
+        bool canReopen() const { return !from_memory; }
+
+        /**
+         * @brief               Method setSheetParts stores the index of the sheet files in the archive.
+         * @param name_part_map map of sheet names to the names of the sheet files.
+         */
+        void setSheetParts(std::map<std::string, std::string> name_part_map) { this->name_part_map = std::move(name_part_map); }
+
+        /**
+         * @brief               Method getSheetPart retrieves the name of the file holding a sheet.
+         * @param sheet_name    string name of the sheet.
+         * @return              std::string name of the sheet file in the archive.
+         * @throws              std::runtime_error if the sheet is not in the archive.
+         */
+        std::string getSheetPart(const std::string &sheet_name) const;
+
+        /**
+         * @brief   Method getSheetParts retrieves the index of the sheet files in the archive.
+         * @return  const std::map<std::string, std::string>& map of sheet names to the names of the sheet files.
+         */
+        const std::map<std::string, std::string> &getSheetParts() const { return name_part_map; }
+
+        /**
+         * @brief   Method readSignature reads the signatures of the shared strings and indexed sheet files, which are
+         *          kept by the archive.
+         * @return  workbook_signature_t signatures of the files, with any file missing from the archive invalid.
+         * @note    The mutex of the archive must be held while reading the signature.
+         */
+        workbook_signature_t readSignature();
+
+        /**
+         * @brief   Method getSignature retrieves the signatures last read by readSignature.
+         * @return  const workbook_signature_t& signatures of the files, empty if they have not been read.
+         */
+        const workbook_signature_t &getSignature() const { return signature; }
+
+        /**
+         * @brief               Method setProjection sets the part of each sheet read from the archive.
+         * @param projection    columns and rows of each sheet to be read.
+         */
+        void setProjection(projection_t projection) { this->projection = std::move(projection); }
+
+        /**
+         * @brief   Method getProjection retrieves the part of each sheet read from the archive.
+         * @return  const projection_t& columns and rows of each sheet to be read.
+         */
+        const projection_t &getProjection() const { return projection; }
+
+        /**
+         * @brief               Method setReadAhead sets whether sheets read from the archive are inflated on a separate
+         *                      thread while they are parsed.
+         * @param read_ahead    whether to inflate each sheet ahead of the parser.
+         */
+        void setReadAhead(bool read_ahead) { this->read_ahead = read_ahead; }
+
+        /**
+         * @brief   Method getReadAhead retrieves whether sheets read from the archive are inflated ahead of the parser.
+         * @return  true if each sheet is inflated on a separate thread while it is parsed.
+         */
+        bool getReadAhead() const { return read_ahead; }
+
+        /**
+         * @brief   Method getBuffer retrieves the buffer that files of the archive are inflated into.
+         * @return  std::vector<char>& buffer reused for every file read through the libzip handle of the archive.
+         * @note    The mutex of the archive must be held while using the buffer.
+         */
+        std::vector<char> &getBuffer() { return buffer; }
+
+    private:
+        /// Name of the Excel file.
+        std::string file_name;
+        /// Contents of the Excel file when supplied by the caller.
+        std::vector<char> contents;
+        /// Pointer to the contents of the Excel file when it is in memory, nullptr when read from the file system.
+        const char *data;
+        /// Number of bytes of the Excel file when it is in memory.
+        size_t size;
+        /// Whether the archive was supplied by the caller as a buffer, so it has no file to be opened again from.
+        bool from_memory;
+        /// Memory mapping of the Excel file, if it was opened with memory_map.
+        std::unique_ptr<MappedFile> mapping;
+        /// libzip handle for the archive.
+        zip *book;
+        /// Mutex guarding the libzip handle.
+        std::mutex mutex;
+        /// Map of sheet names to the names of the sheet files.
+        std::map<std::string, std::string> name_part_map;
+        /// Part of each sheet read from the archive.
+        projection_t projection;
+        /// Whether sheets read from the archive are inflated on a separate thread while they are parsed.
+        bool read_ahead;
+        /// Signatures of the files of the archive, as last read by readSignature.
+        workbook_signature_t signature;
+        /// Buffer reused for every file read through the libzip handle of the archive.
+        std::vector<char> buffer;
+    };
+}
+
+#endif /* WorkbookArchive_HPP */
@@ -0,0 +1,525 @@
+#include "WorkbookCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "ColumnarSheet.hpp"
+#include "MappedFile.hpp"
+#include "SheetArena.hpp"
+
+using namespace excel_parser;
+
+namespace
+{
+	/// Identifies a cache file, followed by the version of its format.
+	const char CACHE_MAGIC[4] = {'X', 'L', 'P', 'C'};
+	const uint32_t CACHE_VERSION = 3;
+
+	/**
+	 * @brief Structural representation of the location of a run of characters in a cache file.
+	 */
+	struct cache_string_t
+	{
+		uint64_t offset;
+		uint64_t length;
+	};
+
+	/**
+	 * @brief Structural representation of the signature of a file in the Excel archive.
+	 */
+	struct cache_part_t
+	{
+		cache_string_t part_name;
+		uint64_t size;
+		uint32_t crc;
+		uint32_t valid;
+	};
+
+	/**
+	 * @brief Structural representation of the header at the start of a cache file.
+	 */
+	struct cache_header_t
+	{
+		char magic[4];
+		uint32_t version;
+		int64_t modified;
+		uint64_t file_size;
+		uint64_t content_hash;
+		cache_string_t file_name;
+		cache_string_t strings;
+		uint64_t spans_offset;
+		uint64_t span_count;
+		cache_part_t shared_strings;
+		uint64_t sheets_offset;
+		uint64_t sheet_count;
+	};
+
+	/**
+	 * @brief Structural representation of the location of a string in the shared strings of a cache file.
+	 */
+	struct cache_span_t
+	{
+		uint64_t offset;
+		uint64_t length;
+	};
+
+	/**
+	 * @brief Structural representation of the entry of a sheet in the directory of a cache file.
+	 */
+	struct cache_sheet_t
+	{
+		cache_string_t name;
+		cache_part_t part;
+		uint64_t rows_offset;
+		uint64_t row_count;
+		uint64_t cells_offset;
+		uint64_t cell_count;
+	};
+
+	/**
+	 * @brief Structural representation of a row of a sheet, whose cells follow those of the previous row.
+	 */
+	struct cache_row_t
+	{
+		int32_t row_id;
+		uint32_t cell_count;
+	};
+
+	/**
+	 * @brief Structural representation of a cell, whose value is a number, a shared string index, or the offset of
+	 *        the cache_string_t locating its text.
+	 */
+	struct cache_cell_t
+	{
+		uint32_t column;
+		uint32_t type;
+		uint64_t value;
+	};
+
+	static_assert(std::is_trivially_copyable<cache_header_t>::value && sizeof(cache_cell_t) == 16, "Cache records must have a fixed layout.");
+
+	/**
+	 * @brief       Function rotateLeft rotates the bits of a 64 bit value.
+	 * @param value value to be rotated.
+	 * @param bits  number of bits to rotate by.
+	 * @return      uint64_t rotated value.
+	 */
+	inline uint64_t rotateLeft(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+	/**
+	 * @brief       Function xxh64 hashes a block of bytes eight bytes at a time with the XXH64 algorithm.
+	 * @param data  pointer to the first byte.
+	 * @param size  number of bytes.
+	 * @return      uint64_t 64 bit hash.
+	 */
+	uint64_t xxh64(const char *data, size_t size)
+	{
+		const uint64_t prime_1 = 11400714785074694791ull;
+		const uint64_t prime_2 = 14029467366897019727ull;
+		const uint64_t prime_3 = 1609587929392839161ull;
+		const uint64_t prime_4 = 9650029242287828579ull;
+		const uint64_t prime_5 = 2870177450012600261ull;
+		auto read_64 = [](const char *p)
+		{
+			uint64_t value;
+			std::memcpy(&value, p, sizeof(value));
+			return value;
+		};
+		auto mix = [](uint64_t accumulator, uint64_t input)
+		{
+			return rotateLeft(accumulator + input * prime_2, 31) * prime_1;
+		};
+
+		const char *p = data;
+		const char *end = data + size;
+		uint64_t hash;
+		if (size >= 32)
+		{
+			// Four independent lanes keep the multipliers busy.
+			uint64_t lanes[4] = {prime_1 + prime_2, prime_2, 0, 0 - prime_1};
+			for (; end - p >= 32; p += 32)
+			{
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					lanes[lane] = mix(lanes[lane], read_64(p + lane * 8));
+				}
+			}
+			hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+			for (uint64_t lane : lanes)
+			{
+				hash = (hash ^ mix(0, lane)) * prime_1 + prime_4;
+			}
+		}
+		else
+		{
+			hash = prime_5;
+		}
+		hash += size;
+
+		for (; end - p >= 8; p += 8)
+		{
+			hash = rotateLeft(hash ^ mix(0, read_64(p)), 27) * prime_1 + prime_4;
+		}
+		if (end - p >= 4)
+		{
+			uint32_t value;
+			std::memcpy(&value, p, sizeof(value));
+			hash = rotateLeft(hash ^ (value * prime_1), 23) * prime_2 + prime_3;
+			p += 4;
+		}
+		for (; p < end; ++p)
+		{
+			hash = rotateLeft(hash ^ (static_cast<unsigned char>(*p) * prime_5), 11) * prime_1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= prime_2;
+		hash ^= hash >> 29;
+		hash *= prime_3;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	/**
+	 * @brief           Function copyText copies the text of an INLINE_STRING or ERROR cell into the memory of a sheet.
+	 * @param arena     arena of the sheet.
+	 * @param text      text of the cell.
+	 * @return          const std::string_view* view of the copy, allocated along with it.
+	 */
+	const std::string_view *copyText(SheetArena &arena, std::string_view text)
+	{
+		void *memory = arena.allocate(sizeof(std::string_view) + text.size(), alignof(std::string_view));
+		char *characters = static_cast<char *>(memory) + sizeof(std::string_view);
+		std::copy(text.begin(), text.end(), characters);
+		return new (memory) std::string_view(characters, text.size());
+	}
+
+	/**
+	 * @brief   Class CacheWriter appends records to the contents of a cache file, each aligned to eight bytes.
+	 */
+	class CacheWriter
+	{
+	public:
+		template <typename T>
+		uint64_t put(const T *records, size_t count)
+		{
+			out.resize((out.size() + 7) & ~size_t(7));
+			uint64_t offset = out.size();
+			out.append(reinterpret_cast<const char *>(records), count * sizeof(T));
+			return offset;
+		}
+
+		cache_string_t putString(std::string_view s)
+		{
+			cache_string_t location;
+			location.offset = put(s.data(), s.size());
+			location.length = s.size();
+			return location;
+		}
+
+		cache_part_t putPart(const part_signature_t &part)
+		{
+			cache_part_t record;
+			record.part_name = putString(part.part_name);
+			record.size = part.size;
+			record.crc = part.crc;
+			record.valid = part.valid;
+			return record;
+		}
+
+		/// Contents of the cache file.
+		std::string out;
+	};
+
+	/**
+	 * @brief   Class CacheReader reads records in place from the contents of a cache file, failing if they lie outside
+	 *          it or are misaligned.
+	 */
+	class CacheReader
+	{
+	public:
+		CacheReader(const char *data, size_t size) : data(data), size(size) {}
+
+		template <typename T>
+		const T *get(uint64_t offset, uint64_t count = 1) const
+		{
+			if (offset % alignof(T) != 0 || offset > size || count > (size - offset) / sizeof(T))
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Cache file is truncated.");
+			}
+			return reinterpret_cast<const T *>(data + offset);
+		}
+
+		std::string_view getString(const cache_string_t &location) const
+		{
+			return std::string_view(get<char>(location.offset, location.length), location.length);
+		}
+
+		part_signature_t getPart(const cache_part_t &record) const
+		{
+			part_signature_t part;
+			part.part_name = std::string(getString(record.part_name));
+			part.size = record.size;
+			part.crc = record.crc;
+			part.valid = record.valid != 0;
+			return part;
+		}
+
+	private:
+		/// Pointer to the first byte of the cache file.
+		const char *data;
+		/// Number of bytes of the cache file.
+		size_t size;
+	};
+}
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+bool WorkbookCache::load(const std::string &file_name, std::shared_ptr<const SharedStringTable> &shared_strings, std::map<std::string, sheet_handle> &sheets, workbook_signature_t &signature) const
+{
+	cache_key_t key;
+	if (!statFile(file_name, key))
+	{
+		return false;
+	}
+
+	try
+	{
+		MappedFile mapping(cachePath(file_name));
+		CacheReader reader(mapping.getData(), mapping.getSize());
+		const cache_header_t &header = *reader.get<cache_header_t>(0);
+		if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+			reader.getString(header.file_name) != file_name || header.file_size != key.size)
+		{
+			return false;
+		}
+		// The contents are only hashed when the modification time no longer matches.
+		if (header.modified != key.modified && (!hashFile(file_name, key.content_hash) || key.content_hash != header.content_hash))
+		{
+			return false;
+		}
+
+		std::shared_ptr<SharedStringTable> strings = std::make_shared<SharedStringTable>();
+		strings->arena = std::string(reader.getString(header.strings));
+		const cache_span_t *spans = reader.get<cache_span_t>(header.spans_offset, header.span_count);
+		strings->spans.resize(header.span_count);
+		for (size_t i = 0; i < strings->spans.size(); ++i)
+		{
+			if (spans[i].offset > strings->arena.size() || spans[i].length > strings->arena.size() - spans[i].offset)
+			{
+				return false;
+			}
+			strings->spans[i].offset = spans[i].offset;
+			strings->spans[i].length = static_cast<uint32_t>(spans[i].length);
+		}
+
+		workbook_signature_t cached_signature;
+		cached_signature.shared_strings = reader.getPart(header.shared_strings);
+		std::map<std::string, sheet_handle> cached_sheets;
+		const cache_sheet_t *entries = reader.get<cache_sheet_t>(header.sheets_offset, header.sheet_count);
+		for (const cache_sheet_t *entry = entries; entry != entries + header.sheet_count; ++entry)
+		{
+			std::string sheet_name(reader.getString(entry->name));
+			const cache_row_t *rows = reader.get<cache_row_t>(entry->rows_offset, entry->row_count);
+			const cache_cell_t *cells = reader.get<cache_cell_t>(entry->cells_offset, entry->cell_count);
+			const cache_cell_t *cells_end = cells + entry->cell_count;
+
+			auto arena = std::make_shared<SheetArena>();
+			sheet &s = arena->getSheet();
+			for (const cache_row_t *record = rows; record != rows + entry->row_count; ++record)
+			{
+				if (record->cell_count > static_cast<uint64_t>(cells_end - cells))
+				{
+					return false;
+				}
+				row &r = s.try_emplace(s.end(), record->row_id)->second;
+				for (const cache_cell_t *c = cells; c != cells + record->cell_count; ++c)
+				{
+					CellType type = static_cast<CellType>(c->type);
+					if (type == STRING)
+					{
+						r.set(static_cast<int>(c->column), cell_t::makeString(static_cast<uint32_t>(c->value)));
+					}
+					else if (type == INLINE_STRING || type == ERROR)
+					{
+						std::string_view text = reader.getString(*reader.get<cache_string_t>(c->value));
+						r.set(static_cast<int>(c->column), cell_t::makeText(type, copyText(*arena, text)));
+					}
+					else
+					{
+						double number;
+						std::memcpy(&number, &c->value, sizeof(number));
+						r.set(static_cast<int>(c->column), cell_t::makeNumber(number));
+					}
+				}
+				cells += record->cell_count;
+			}
+			cached_signature.sheets.emplace(sheet_name, reader.getPart(entry->part));
+			cached_sheets.emplace(std::move(sheet_name), SheetArena::share(arena));
+		}
+
+		shared_strings = std::move(strings);
+		sheets = std::move(cached_sheets);
+		signature = std::move(cached_signature);
+		return true;
+	}
+	catch (std::runtime_error &)
+	{
+		return false;
+	}
+}
+
+bool WorkbookCache::store(const std::string &file_name, const SharedStringTable &shared_strings, const std::map<std::string, sheet_handle> &sheets, const workbook_signature_t &signature) const
+{
+	cache_key_t key;
+	if (!statFile(file_name, key) || !hashFile(file_name, key.content_hash))
+	{
+		return false;
+	}
+
+	// The header is written last, once the offset of every section is known.
+	CacheWriter writer;
+	cache_header_t header = {};
+	writer.put(&header, 1);
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.modified = key.modified;
+	header.file_size = key.size;
+	header.content_hash = key.content_hash;
+	header.file_name = writer.putString(file_name);
+	header.strings = writer.putString(shared_strings.arena);
+	std::vector<cache_span_t> spans;
+	spans.reserve(shared_strings.spans.size());
+	for (auto &span : shared_strings.spans)
+	{
+		spans.push_back(cache_span_t{span.offset, span.length});
+	}
+	header.spans_offset = writer.put(spans.data(), spans.size());
+	header.span_count = spans.size();
+	header.shared_strings = writer.putPart(signature.shared_strings);
+
+	std::vector<cache_sheet_t> entries;
+	for (auto &name_sheet : sheets)
+	{
+		auto part = signature.sheets.find(name_sheet.first);
+		if (part == signature.sheets.end())
+		{
+			return false;
+		}
+		cache_sheet_t entry = {};
+		entry.name = writer.putString(name_sheet.first);
+		entry.part = writer.putPart(part->second);
+
+		// The text of each cell is written before the cells, which hold its location.
+		std::vector<cache_row_t> rows;
+		std::vector<cache_cell_t> cells;
+		for (auto &row_cells : *name_sheet.second)
+		{
+			rows.push_back(cache_row_t{static_cast<int32_t>(row_cells.first), static_cast<uint32_t>(row_cells.second.size())});
+			for (auto &column_cell : row_cells.second)
+			{
+				cache_cell_t c = {static_cast<uint32_t>(column_cell.first), static_cast<uint32_t>(column_cell.second.type), 0};
+				if (column_cell.second.type == STRING)
+				{
+					c.value = column_cell.second.getStringIndex();
+				}
+				else if (column_cell.second.type == INLINE_STRING || column_cell.second.type == ERROR)
+				{
+					cache_string_t text = writer.putString(column_cell.second.getText());
+					c.value = writer.put(&text, 1);
+				}
+				else
+				{
+					double number = column_cell.second.getNumber();
+					std::memcpy(&c.value, &number, sizeof(number));
+				}
+				cells.push_back(c);
+			}
+		}
+		entry.rows_offset = writer.put(rows.data(), rows.size());
+		entry.row_count = rows.size();
+		entry.cells_offset = writer.put(cells.data(), cells.size());
+		entry.cell_count = cells.size();
+		entries.push_back(entry);
+	}
+	header.sheets_offset = writer.put(entries.data(), entries.size());
+	header.sheet_count = entries.size();
+	std::memcpy(&writer.out[0], &header, sizeof(header));
+
+	// Every writer uses a temporary file of its own, created exclusively so that two writers never share one.
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	std::string path = cachePath(file_name);
+	std::string temporary_path;
+	std::FILE *file = nullptr;
+	std::random_device random;
+	for (int attempt = 0; attempt < 8 && file == nullptr; ++attempt)
+	{
+		char suffix[32];
+		std::snprintf(suffix, sizeof(suffix), ".%08x%08x.tmp", static_cast<unsigned>(random()), static_cast<unsigned>(random()));
+		temporary_path = path + suffix;
+		file = std::fopen(temporary_path.c_str(), "wbx");
+	}
+	if (file == nullptr)
+	{
+		return false;
+	}
+	bool written = std::fwrite(writer.out.data(), 1, writer.out.size(), file) == writer.out.size();
+	written = std::fclose(file) == 0 && written;
+	if (written)
+	{
+		std::filesystem::rename(temporary_path, path, error);
+	}
+	if (!written || error)
+	{
+		std::filesystem::remove(temporary_path, error);
+		return false;
+	}
+	return true;
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+bool WorkbookCache::statFile(const std::string &file_name, cache_key_t &key)
+{
+	std::error_code error;
+	auto modified = std::filesystem::last_write_time(file_name, error);
+	if (error)
+	{
+		return false;
+	}
+	key.modified = static_cast<int64_t>(modified.time_since_epoch().count());
+	key.size = static_cast<uint64_t>(std::filesystem::file_size(file_name, error));
+	key.content_hash = 0;
+	return !error;
+}
+
+bool WorkbookCache::hashFile(const std::string &file_name, uint64_t &hash)
+{
+	try
+	{
+		MappedFile mapping(file_name);
+		hash = xxh64(mapping.getData(), mapping.getSize());
+		return true;
+	}
+	catch (std::runtime_error &)
+	{
+		return false;
+	}
+}
+
+std::string WorkbookCache::cachePath(const std::string &file_name) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.xlcache", static_cast<unsigned long long>(xxh64(file_name.data(), file_name.size())));
+	return (std::filesystem::path(directory) / name).string();
+}
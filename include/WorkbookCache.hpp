@@ -0,0 +1,111 @@
+/**
+ * @file    WorkbookCache.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the WorkbookCache, an on-disk cache of parsed Excel files.
+ * @details The WorkbookCache stores the shared strings and sheets of a parsed Excel file in a binary file of fixed
+ *          layout records, so that opening the same file again maps the cache into memory and copies the cells out
+ *          of it instead of inflating and parsing its XML.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef WorkbookCache_HPP
+#define WorkbookCache_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "ExcelTypes.hpp"
+#include "SharedStringTable.hpp"
+#include "WorkbookArchive.hpp"
+
+namespace excel_parser
+{
+    /**
+     * @brief   Class WorkbookCache reads and writes cache files of parsed Excel files in a directory.
+     * @details Each Excel file has one cache file, named from a hash of its path. The cache file records the
+     *          modification time, size, and a hash of the contents of the Excel file. It is used without reading the
+     *          Excel file while the modification time and size match, and the contents are only hashed when the
+     *          modification time has changed, so a file that was touched or copied without changing keeps its cache.
+     *          A header at the start of the cache file holds the offset of every section, and a directory holds the
+     *          offsets of the rows and cells of each sheet, so every record is read in place from the mapping.
+     * @note    Records are stored in the byte order of the machine that wrote them, as cache files are local.
+     */
+    class WorkbookCache
+    {
+    public:
+        /**
+         * @brief               Constructor for the WorkbookCache class.
+         * @param directory     string path of the directory the cache files are stored in, which is created if it
+         *                      does not exist.
+         */
+        explicit WorkbookCache(std::string directory) : directory(std::move(directory)) {}
+
+        /**
+         * @brief                   Method load reads the parsed contents of an Excel file from its cache file.
+         * @param file_name         string name of the Excel file.
+         * @param shared_strings    handle set to the shared strings of the file on success.
+         * @param sheets            map set to the sheets of the file on success.
+         * @param signature         structure set to the signatures of the parts of the Excel file on success.
+         * @return                  true if a cache file matching the current contents of the Excel file was read.
+         */
+        bool load(const std::string &file_name, std::shared_ptr<const SharedStringTable> &shared_strings, std::map<std::string, sheet_handle> &sheets, workbook_signature_t &signature) const;
+
+        /**
+         * @brief                   Method store writes the parsed contents of an Excel file to its cache file.
+         * @param file_name         string name of the Excel file.
+         * @param shared_strings    shared strings of the file.
+         * @param sheets            sheets of the file.
+         * @param signature         signatures of the parts of the Excel file the sheets were read from.
+         * @return                  true if the cache file was written.
+         * @note                    The cache file is written under a temporary name unique to the writer and then
+         *                          renamed, so a reader never sees a partially written cache file and concurrent
+         *                          writers never write to the same file.
+         */
+        bool store(const std::string &file_name, const SharedStringTable &shared_strings, const std::map<std::string, sheet_handle> &sheets, const workbook_signature_t &signature) const;
+
+    private:
+        /**
+         * @brief Structural representation of the properties of an Excel file that a cache file must match.
+         */
+        struct cache_key_t
+        {
+            /// Modification time of the Excel file.
+            int64_t modified;
+            /// Size of the Excel file in bytes.
+            uint64_t size;
+            /// Hash of the contents of the Excel file.
+            uint64_t content_hash;
+        };
+
+        /**
+         * @brief           Method statFile reads the modification time and size of an Excel file.
+         * @param file_name string name of the Excel file.
+         * @param key       structure the modification time and size are written to.
+         * @return          true if the file exists.
+         */
+        static bool statFile(const std::string &file_name, cache_key_t &key);
+
+        /**
+         * @brief           Method hashFile hashes the contents of an Excel file.
+         * @param file_name string name of the Excel file.
+         * @param hash      set to the hash of the contents.
+         * @return          true if the file could be read.
+         */
+        static bool hashFile(const std::string &file_name, uint64_t &hash);
+
+        /**
+         * @brief           Method cachePath builds the path of the cache file of an Excel file.
+         * @param file_name string name of the Excel file.
+         * @return          std::string path of the cache file.
+         */
+        std::string cachePath(const std::string &file_name) const;
+
+        /// Path of the directory the cache files are stored in.
+        std::string directory;
+    };
+}
+
+#endif /* WorkbookCache_HPP */
@@ -0,0 +1,583 @@
+#include "XmlStreamReader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "SimdScan.hpp"
+
+using namespace excel_parser;
+
+/********************************************************************************************************************
+ * BYTE SOURCES *****************************************************************************************************
+ ********************************************************************************************************************/
+ZipEntrySource::~ZipEntrySource()
+{
+	zip_fclose(file);
+}
+
+size_t ZipEntrySource::read(char *buffer, size_t size)
+{
+	auto start = std::chrono::steady_clock::now();
+	zip_int64_t bytes_read = zip_fread(file, buffer, size);
+	inflate_time += std::chrono::steady_clock::now() - start;
+	if (bytes_read < 0)
+	{
+		throw std::runtime_error("[Excel Parser] (ERROR) Error inflating file from the archive.");
+	}
+	return static_cast<size_t>(bytes_read);
+}
+
+size_t MemorySource::read(char *buffer, size_t size)
+{
+	size_t bytes_read = std::min(size, this->size - position);
+	std::memcpy(buffer, data + position, bytes_read);
+	position += bytes_read;
+	return bytes_read;
+}
+
+PrefetchSource::PrefetchSource(ByteSource &source, size_t block_count, size_t block_size)
+	: source(source), blocks(std::max<size_t>(2, block_count)), read_block(0), read_offset(0), filled(0), finished(false), stopping(false), wait_time(0)
+{
+	for (block_t &block : blocks)
+	{
+		block.data.resize(block_size);
+	}
+	producer = std::thread(&PrefetchSource::produce, this);
+}
+
+PrefetchSource::~PrefetchSource()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	producer.join();
+}
+
+size_t PrefetchSource::read(char *buffer, size_t size)
+{
+	size_t copied = 0;
+	while (copied < size)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (filled == 0)
+			{
+				// Hand back what has been copied rather than waiting for more.
+				if (copied > 0 || finished)
+				{
+					if (copied == 0 && error)
+					{
+						std::rethrow_exception(error);
+					}
+					break;
+				}
+				auto start = std::chrono::steady_clock::now();
+				condition.wait(lock, [this]()
+							   { return filled > 0 || finished; });
+				wait_time += std::chrono::steady_clock::now() - start;
+				continue;
+			}
+		}
+
+		// A complete block is never touched by the producer, so it is copied without holding the lock.
+		block_t &block = blocks[read_block];
+		size_t bytes = std::min(size - copied, block.size - read_offset);
+		std::memcpy(buffer + copied, block.data.data() + read_offset, bytes);
+		copied += bytes;
+		read_offset += bytes;
+		if (read_offset == block.size)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				--filled;
+			}
+			condition.notify_all();
+			read_block = (read_block + 1) % blocks.size();
+			read_offset = 0;
+		}
+	}
+	return copied;
+}
+
+void PrefetchSource::produce()
+{
+	for (size_t write_block = 0;; write_block = (write_block + 1) % blocks.size())
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]()
+						   { return stopping || filled < blocks.size(); });
+			if (stopping)
+			{
+				return;
+			}
+		}
+
+		// The block is free, so it is filled without holding the lock.
+		block_t &block = blocks[write_block];
+		block.size = 0;
+		try
+		{
+			while (block.size < block.data.size())
+			{
+				size_t bytes_read = source.read(block.data.data() + block.size, block.data.size() - block.size);
+				if (bytes_read == 0)
+				{
+					break;
+				}
+				block.size += bytes_read;
+			}
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			error = std::current_exception();
+			block.size = 0;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (block.size > 0)
+			{
+				++filled;
+			}
+			if (block.size < block.data.size())
+			{
+				finished = true;
+			}
+		}
+		condition.notify_all();
+		if (block.size < block.data.size())
+		{
+			return;
+		}
+	}
+}
+
+/********************************************************************************************************************
+ * PUBLIC METHODS ***************************************************************************************************
+ ********************************************************************************************************************/
+XmlStreamReader::XmlStreamReader(ByteSource &source, size_t chunk_size)
+	: XmlStreamReader(source, owned_buffer, chunk_size)
+{
+}
+
+XmlStreamReader::XmlStreamReader(ByteSource &source, std::vector<char> &buffer, size_t chunk_size)
+	: source(&source), chunk_size(chunk_size), buffer(buffer), position(0), limit(0), exhausted(false), pending_end(false)
+{
+	if (buffer.size() < chunk_size)
+	{
+		buffer.resize(chunk_size);
+	}
+}
+
+XmlStreamReader::XmlStreamReader(std::vector<char> &document)
+	: source(nullptr), chunk_size(0), buffer(document), position(0), limit(document.size()), exhausted(true), pending_end(false)
+{
+}
+
+XmlEvent XmlStreamReader::next()
+{
+	attributes.clear();
+	decoded.clear();
+	if (pending_end)
+	{
+		pending_end = false;
+		element_name = pending_name;
+		return END_ELEMENT;
+	}
+
+	for (;;)
+	{
+		if (position == limit && !fill())
+		{
+			return END_DOCUMENT;
+		}
+
+		// Character data runs up to the next tag (or the end of the document).
+		if (buffer[position] != '<')
+		{
+			size_t end = find('<', 0);
+			if (end == std::string::npos)
+			{
+				end = limit - position;
+			}
+			element_text = decode(std::string_view(buffer.data() + position, end));
+			position += end;
+			return TEXT;
+		}
+
+		// Make sure enough of the tag is buffered to tell what kind of markup it is.
+		while (limit - position < 9 && fill())
+		{
+		}
+		std::string_view markup(buffer.data() + position, limit - position);
+
+		if (markup.compare(0, 2, "<?") == 0)
+		{
+			size_t end = findSequence("?>", 2);
+			if (end == std::string::npos)
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Unterminated processing instruction in XML.");
+			}
+			position += end + 2;
+		}
+		else if (markup.compare(0, 4, "<!--") == 0)
+		{
+			size_t end = findSequence("-->", 4);
+			if (end == std::string::npos)
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Unterminated comment in XML.");
+			}
+			position += end + 3;
+		}
+		else if (markup.compare(0, 9, "<![CDATA[") == 0)
+		{
+			size_t end = findSequence("]]>", 9);
+			if (end == std::string::npos)
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Unterminated CDATA section in XML.");
+			}
+			element_text = std::string_view(buffer.data() + position + 9, end - 9);
+			position += end + 3;
+			return TEXT;
+		}
+		else if (markup.compare(0, 2, "<!") == 0)
+		{
+			size_t end = findTagEnd();
+			if (end == std::string::npos)
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Unterminated declaration in XML.");
+			}
+			position += end + 1;
+		}
+		else if (markup.compare(0, 2, "</") == 0)
+		{
+			size_t end = find('>', 2);
+			if (end == std::string::npos)
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Unterminated end tag in XML.");
+			}
+			const char *name_begin = buffer.data() + position + 2;
+			const char *name_end = buffer.data() + position + end;
+			while (name_end > name_begin && std::isspace(static_cast<unsigned char>(name_end[-1])))
+			{
+				--name_end;
+			}
+			element_name = std::string_view(name_begin, name_end - name_begin);
+			size_t colon = element_name.rfind(':');
+			if (colon != std::string_view::npos)
+			{
+				element_name.remove_prefix(colon + 1);
+			}
+			position += end + 1;
+			return END_ELEMENT;
+		}
+		else
+		{
+			size_t end = findTagEnd();
+			if (end == std::string::npos)
+			{
+				throw std::runtime_error("[Excel Parser] (ERROR) Unterminated start tag in XML.");
+			}
+			const char *tag_begin = buffer.data() + position + 1;
+			const char *tag_end = buffer.data() + position + end;
+			bool empty = end > 1 && tag_end[-1] == '/';
+			parseTag(tag_begin, empty ? tag_end - 1 : tag_end);
+			position += end + 1;
+			if (empty)
+			{
+				pending_end = true;
+				pending_name.assign(element_name.data(), element_name.size());
+			}
+			return START_ELEMENT;
+		}
+	}
+}
+
+bool XmlStreamReader::attribute(std::string_view attribute_name, std::string_view &value) const
+{
+	for (auto &a : attributes)
+	{
+		if (a.first == attribute_name)
+		{
+			value = a.second;
+			return true;
+		}
+	}
+	return false;
+}
+
+void XmlStreamReader::skipElement()
+{
+	int depth = 1;
+	while (depth > 0)
+	{
+		switch (next())
+		{
+		case START_ELEMENT:
+			++depth;
+			break;
+		case END_ELEMENT:
+			--depth;
+			break;
+		case END_DOCUMENT:
+			throw std::runtime_error("[Excel Parser] (ERROR) Unexpected end of XML document inside an element.");
+		default:
+			break;
+		}
+	}
+}
+
+/********************************************************************************************************************
+ * PRIVATE METHODS **************************************************************************************************
+ ********************************************************************************************************************/
+bool XmlStreamReader::fill()
+{
+	if (exhausted)
+	{
+		return false;
+	}
+
+	// Discard the consumed part of the window so offsets from the current position stay valid.
+	if (position > 0)
+	{
+		std::memmove(buffer.data(), buffer.data() + position, limit - position);
+		limit -= position;
+		position = 0;
+	}
+	if (buffer.size() - limit < chunk_size)
+	{
+		buffer.resize(limit + chunk_size);
+	}
+
+	size_t bytes_read = source->read(buffer.data() + limit, chunk_size);
+	if (bytes_read == 0)
+	{
+		exhausted = true;
+		return false;
+	}
+	limit += bytes_read;
+	return true;
+}
+
+size_t XmlStreamReader::find(char c, size_t from)
+{
+	for (;;)
+	{
+		if (position + from < limit)
+		{
+			const void *found = std::memchr(buffer.data() + position + from, c, limit - position - from);
+			if (found != nullptr)
+			{
+				return static_cast<const char *>(found) - (buffer.data() + position);
+			}
+			from = limit - position;
+		}
+		if (!fill())
+		{
+			return std::string::npos;
+		}
+	}
+}
+
+size_t XmlStreamReader::findTagEnd()
+{
+	size_t offset = 1;
+	char quote = 0;
+	for (;;)
+	{
+		const char *data = buffer.data() + position;
+		size_t available = limit - position;
+		while (offset < available)
+		{
+			// Inside a quoted value only the closing quote matters, outside it either quote or the '>'.
+			if (quote)
+			{
+				const void *found = std::memchr(data + offset, quote, available - offset);
+				if (found == nullptr)
+				{
+					offset = available;
+					break;
+				}
+				offset = static_cast<const char *>(found) - data + 1;
+				quote = 0;
+				continue;
+			}
+			offset += simd::findAny(data + offset, available - offset, '>', '"', '\'');
+			if (offset == available)
+			{
+				break;
+			}
+			if (data[offset] == '>')
+			{
+				return offset;
+			}
+			quote = data[offset++];
+		}
+		if (!fill())
+		{
+			return std::string::npos;
+		}
+	}
+}
+
+size_t XmlStreamReader::findSequence(std::string_view seq, size_t from)
+{
+	for (;;)
+	{
+		std::string_view window(buffer.data() + position, limit - position);
+		size_t found = window.find(seq, from);
+		if (found != std::string_view::npos)
+		{
+			return found;
+		}
+		if (window.size() >= seq.size())
+		{
+			from = std::max(from, window.size() - seq.size() + 1);
+		}
+		if (!fill())
+		{
+			return std::string::npos;
+		}
+	}
+}
+
+void XmlStreamReader::parseTag(const char *begin, const char *end)
+{
+	auto is_space = [](char c)
+	{ return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+
+	const char *p = begin;
+	while (p < end && !is_space(*p))
+	{
+		++p;
+	}
+	element_name = std::string_view(begin, p - begin);
+	size_t colon = element_name.rfind(':');
+	if (colon != std::string_view::npos)
+	{
+		element_name.remove_prefix(colon + 1);
+	}
+
+	for (;;)
+	{
+		while (p < end && is_space(*p))
+		{
+			++p;
+		}
+		if (p >= end)
+		{
+			break;
+		}
+		const char *attribute_begin = p;
+		while (p < end && *p != '=' && !is_space(*p))
+		{
+			++p;
+		}
+		std::string_view attribute_name(attribute_begin, p - attribute_begin);
+		while (p < end && is_space(*p))
+		{
+			++p;
+		}
+		if (p >= end || *p != '=')
+		{
+			throw std::runtime_error("[Excel Parser] (ERROR) Malformed attribute in XML element " + std::string(element_name));
+		}
+		++p;
+		while (p < end && is_space(*p))
+		{
+			++p;
+		}
+		if (p >= end || (*p != '"' && *p != '\''))
+		{
+			throw std::runtime_error("[Excel Parser] (ERROR) Unquoted attribute value in XML element " + std::string(element_name));
+		}
+		char quote = *p++;
+		const char *value_begin = p;
+		p = static_cast<const char *>(std::memchr(p, quote, end - p));
+		if (p == nullptr)
+		{
+			throw std::runtime_error("[Excel Parser] (ERROR) Unterminated attribute value in XML element " + std::string(element_name));
+		}
+		attributes.emplace_back(attribute_name, decode(std::string_view(value_begin, p - value_begin)));
+		++p;
+	}
+}
+
+std::string_view XmlStreamReader::decode(std::string_view raw)
+{
+	size_t amp = raw.find('&');
+	if (amp == std::string_view::npos)
+	{
+		return raw;
+	}
+
+	std::string &out = decoded.emplace_back();
+	out.reserve(raw.size());
+	out.append(raw.data(), amp);
+	for (size_t i = amp; i < raw.size();)
+	{
+		if (raw[i] != '&')
+		{
+			out.push_back(raw[i++]);
+			continue;
+		}
+		size_t semicolon = raw.find(';', i);
+		if (semicolon == std::string_view::npos)
+		{
+			out.append(raw.substr(i));
+			break;
+		}
+		std::string_view entity = raw.substr(i + 1, semicolon - i - 1);
+		if (entity == "lt")
+			out.push_back('<');
+		else if (entity == "gt")
+			out.push_back('>');
+		else if (entity == "amp")
+			out.push_back('&');
+		else if (entity == "quot")
+			out.push_back('"');
+		else if (entity == "apos")
+			out.push_back('\'');
+		else if (entity.size() > 1 && entity[0] == '#')
+		{
+			unsigned long code = (entity[1] == 'x' || entity[1] == 'X')
+									 ? std::strtoul(std::string(entity.substr(2)).c_str(), nullptr, 16)
+									 : std::strtoul(std::string(entity.substr(1)).c_str(), nullptr, 10);
+			// Encode the code point as UTF-8.
+			if (code < 0x80)
+			{
+				out.push_back(static_cast<char>(code));
+			}
+			else if (code < 0x800)
+			{
+				out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else if (code < 0x10000)
+			{
+				out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+			else
+			{
+				out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+				out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+			}
+		}
+		else
+		{
+			out.append(raw.substr(i, semicolon - i + 1));
+		}
+		i = semicolon + 1;
+	}
+	return out;
+}
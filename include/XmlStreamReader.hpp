@@ -0,0 +1,337 @@
+/**
+ * @file    XmlStreamReader.hpp
+ * @author  James Horner
+ * @brief   This file contains the declaration of the XmlStreamReader, a pull parser for the XML parts of Excel files.
+ * @details The XmlStreamReader reads XML incrementally from a ByteSource (such as a libzip decompression stream) and
+ *          reports elements and text one event at a time so that the whole document never has to be held in memory.
+ * @date    2022-07-07
+ *
+ * @copyright Copyright (c) 2022
+ */
+#ifndef XmlStreamReader_HPP
+#define XmlStreamReader_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <zip.h>
+
+namespace excel_parser
+{
+    /**
+     * @brief   Interface ByteSource supplies raw bytes to an XmlStreamReader.
+     */
+    class ByteSource
+    {
+    public:
+        virtual ~ByteSource() = default;
+
+        /**
+         * @brief           Method read copies up to size bytes into the buffer.
+         * @param buffer    pointer to the memory to be filled.
+         * @param size      maximum number of bytes to copy.
+         * @return          size_t number of bytes copied, 0 once the source is exhausted.
+         */
+        virtual size_t read(char *buffer, size_t size) = 0;
+    };
+
+    /**
+     * @brief   Class ZipEntrySource is a ByteSource that inflates a file from an Excel archive as it is read.
+     * @note    The source takes ownership of the libzip file handle and closes it on destruction.
+     */
+    class ZipEntrySource : public ByteSource
+    {
+    public:
+        /**
+         * @brief           Constructor for the ZipEntrySource class.
+         * @param file      libzip handle for the opened archive entry.
+         */
+        explicit ZipEntrySource(zip_file *file) : file(file), inflate_time(0) {}
+        ~ZipEntrySource() override;
+
+        ZipEntrySource(const ZipEntrySource &) = delete;
+        void operator=(const ZipEntrySource &) = delete;
+
+        size_t read(char *buffer, size_t size) override;
+
+        /**
+         * @brief   Method getInflateTime retrieves the total time spent inflating data in read.
+         * @return  std::chrono::nanoseconds time spent in zip_fread.
+         */
+        std::chrono::nanoseconds getInflateTime() const { return inflate_time; }
+
+    private:
+        /// libzip handle for the archive entry being inflated.
+        zip_file *file;
+        /// Total time spent in zip_fread.
+        std::chrono::nanoseconds inflate_time;
+    };
+
+    /**
+     * @brief   Class MemorySource is a ByteSource over a block of memory that is owned by the caller.
+     */
+    class MemorySource : public ByteSource
+    {
+    public:
+        /**
+         * @brief           Constructor for the MemorySource class.
+         * @param data      pointer to the first byte of the memory.
+         * @param size      number of bytes available.
+         */
+        MemorySource(const char *data, size_t size) : data(data), size(size), position(0) {}
+
+        size_t read(char *buffer, size_t size) override;
+
+    private:
+        /// Pointer to the first byte of the memory.
+        const char *data;
+        /// Number of bytes available.
+        size_t size;
+        /// Number of bytes already read.
+        size_t position;
+    };
+
+    /**
+     * @brief   Class PrefetchSource is a ByteSource that reads ahead of its consumer on a separate thread.
+     * @details A producer thread reads from the underlying source into a ring of fixed size blocks while the consumer
+     *          copies out of the blocks that are complete, so inflating a sheet file overlaps with parsing it. The
+     *          producer waits whenever every block is full, which bounds the memory held to the size of the ring.
+     * @note    The underlying source must not be used by anything else until the PrefetchSource is destroyed.
+     */
+    class PrefetchSource : public ByteSource
+    {
+    public:
+        /**
+         * @brief               Constructor for the PrefetchSource class, which starts the producer thread.
+         * @param source        ByteSource read by the producer, which must outlive the PrefetchSource.
+         * @param block_count   number of blocks in the ring.
+         * @param block_size    size in bytes of each block.
+         */
+        explicit PrefetchSource(ByteSource &source, size_t block_count = 4, size_t block_size = 256 * 1024);
+
+        /**
+         * @brief   Destructor for the PrefetchSource class which stops the producer and waits for it to finish.
+         */
+        ~PrefetchSource() override;
+
+        PrefetchSource(const PrefetchSource &) = delete;
+        void operator=(const PrefetchSource &) = delete;
+
+        /**
+         * @brief   Method read copies bytes out of the blocks that are complete, waiting only if there are none.
+         * @throws  the exception thrown by the underlying source, once every byte read before it has been consumed.
+         */
+        size_t read(char *buffer, size_t size) override;
+
+        /**
+         * @brief   Method getWaitTime retrieves the total time the consumer spent waiting for the producer.
+         * @return  std::chrono::nanoseconds time spent waiting in read.
+         */
+        std::chrono::nanoseconds getWaitTime() const { return wait_time; }
+
+    private:
+        /**
+         * @brief   Structural representation of a block of the ring.
+         */
+        struct block_t
+        {
+            /// Storage for the bytes of the block.
+            std::vector<char> data;
+            /// Number of valid bytes in the block.
+            size_t size = 0;
+        };
+
+        /**
+         * @brief   Method produce is run by the producer thread to fill the blocks until the source is exhausted.
+         */
+        void produce();
+
+        /// ByteSource read by the producer.
+        ByteSource &source;
+        /// Ring of blocks.
+        std::vector<block_t> blocks;
+        /// Index of the block being consumed.
+        size_t read_block;
+        /// Offset of the next byte to be consumed in the block being consumed.
+        size_t read_offset;
+        /// Number of blocks that are complete and not yet consumed.
+        size_t filled;
+        /// Whether the producer has reached the end of the source or failed.
+        bool finished;
+        /// Whether the producer has been asked to stop.
+        bool stopping;
+        /// Exception thrown by the source, if any.
+        std::exception_ptr error;
+        /// Total time the consumer spent waiting for the producer.
+        std::chrono::nanoseconds wait_time;
+        /// Mutex to control access to the counts and flags.
+        std::mutex mutex;
+        /// Condition signalled when a block is filled or consumed.
+        std::condition_variable condition;
+        /// Thread running produce.
+        std::thread producer;
+    };
+
+    /**
+     * @brief Enumeration of the different events reported by the XmlStreamReader.
+     */
+    typedef enum
+    {
+        START_ELEMENT,
+        END_ELEMENT,
+        TEXT,
+        END_DOCUMENT
+    } XmlEvent;
+
+    /**
+     * @brief   Class XmlStreamReader is a pull parser that tokenises XML read incrementally from a ByteSource.
+     * @details Only a window of the document is buffered at a time. Empty elements are reported as a START_ELEMENT
+     *          immediately followed by an END_ELEMENT. Processing instructions, comments, and declarations are
+     *          skipped, and CDATA sections are reported as TEXT.
+     * @note    Views returned by name, text, and attribute are only valid until the next call to next.
+     */
+    class XmlStreamReader
+    {
+    public:
+        /**
+         * @brief               Constructor for the XmlStreamReader class.
+         * @param source        ByteSource the XML is read from, which must outlive the reader.
+         * @param chunk_size    number of bytes requested from the source at a time.
+         */
+        explicit XmlStreamReader(ByteSource &source, size_t chunk_size = 64 * 1024);
+
+        /**
+         * @brief               Constructor for an XmlStreamReader that buffers its window in memory owned by the caller.
+         * @param source        ByteSource the XML is read from, which must outlive the reader.
+         * @param buffer        buffer for the window, which must outlive the reader and can be reused by later readers
+         *                      so that parsing several files only grows a single allocation.
+         * @param chunk_size    number of bytes requested from the source at a time.
+         */
+        XmlStreamReader(ByteSource &source, std::vector<char> &buffer, size_t chunk_size = 64 * 1024);
+
+        /**
+         * @brief               Constructor for an XmlStreamReader over a whole document that is already in memory.
+         * @param document      buffer holding the document, which is parsed in place and must outlive the reader.
+         */
+        explicit XmlStreamReader(std::vector<char> &document);
+
+        XmlStreamReader(const XmlStreamReader &) = delete;
+        void operator=(const XmlStreamReader &) = delete;
+
+        /**
+         * @brief   Method next advances the reader to the next event in the document.
+         * @return  XmlEvent type of the event that was read.
+         * @throws  std::runtime_error if the document is malformed.
+         */
+        XmlEvent next();
+
+        /**
+         * @brief   Method name retrieves the name of the current element without any namespace prefix.
+         * @return  std::string_view local name of the element for START_ELEMENT and END_ELEMENT events.
+         */
+        std::string_view name() const { return element_name; }
+
+        /**
+         * @brief   Method text retrieves the text of the current TEXT event with entities decoded.
+         * @return  std::string_view decoded text.
+         */
+        std::string_view text() const { return element_text; }
+
+        /**
+         * @brief                   Method attribute retrieves the value of an attribute of the current START_ELEMENT.
+         * @param attribute_name    qualified name of the attribute (e.g. "r:id").
+         * @param value             string_view set to the decoded value when the attribute exists.
+         * @return                  true if the element has the attribute, false otherwise.
+         */
+        bool attribute(std::string_view attribute_name, std::string_view &value) const;
+
+        /**
+         * @brief           Method skipElement consumes the rest of the current element including all its children.
+         * @note            Must only be called directly after a START_ELEMENT event.
+         */
+        void skipElement();
+
+    private:
+        /**
+         * @brief   Method fill reads more data from the source, discarding everything before the current position.
+         * @return  true if any bytes were added to the buffer, false if the source is exhausted.
+         */
+        bool fill();
+
+        /**
+         * @brief       Method find searches the buffered data for a character, reading more data as required.
+         * @param c     character to search for.
+         * @param from  offset from the current position at which to start searching.
+         * @return      size_t offset of the character from the current position, or npos if it was never found.
+         */
+        size_t find(char c, size_t from);
+
+        /**
+         * @brief       Method findTagEnd searches for the '>' that closes the tag at the current position, ignoring
+         *              any '>' characters inside quoted attribute values.
+         * @return      size_t offset of the '>' from the current position.
+         */
+        size_t findTagEnd();
+
+        /**
+         * @brief       Method findSequence searches for a sequence of characters, reading more data as required.
+         * @param seq   sequence to search for.
+         * @param from  offset from the current position at which to start searching.
+         * @return      size_t offset of the sequence from the current position.
+         */
+        size_t findSequence(std::string_view seq, size_t from);
+
+        /**
+         * @brief       Method parseTag parses the element name and attributes of the start tag [begin, end).
+         * @param begin pointer to the first character after '<'.
+         * @param end   pointer to the closing '>' (or '/' for empty elements).
+         */
+        void parseTag(const char *begin, const char *end);
+
+        /**
+         * @brief       Method decode replaces the XML entities in a string, storing the result if required.
+         * @param raw   text as it appears in the document.
+         * @return      std::string_view to the decoded text.
+         */
+        std::string_view decode(std::string_view raw);
+
+        /// ByteSource the XML is read from, or nullptr if the whole document is already buffered.
+        ByteSource *source;
+        /// Number of bytes requested from the source at a time.
+        size_t chunk_size;
+        /// Storage for the window when the caller does not supply a buffer.
+        std::vector<char> owned_buffer;
+        /// Window of the document that is currently buffered.
+        std::vector<char> &buffer;
+        /// Offset in the buffer of the next unread character.
+        size_t position;
+        /// Offset in the buffer one past the last valid character.
+        size_t limit;
+        /// Whether the source has been exhausted.
+        bool exhausted;
+        /// Whether an empty element is waiting for its END_ELEMENT event.
+        bool pending_end;
+        /// Copy of the name of the empty element waiting for its END_ELEMENT event.
+        std::string pending_name;
+        /// Name of the current element.
+        std::string_view element_name;
+        /// Text of the current TEXT event.
+        std::string_view element_text;
+        /// Attributes of the current START_ELEMENT event.
+        std::vector<std::pair<std::string_view, std::string_view>> attributes;
+        /// Storage for text and attribute values that contained entities.
+        std::deque<std::string> decoded;
+    };
+}
+
+#endif /* XmlStreamReader_HPP */
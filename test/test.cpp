@@ -1,8 +1,15 @@
+#include <atomic>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <thread>
 
 #include "DirectoryConfig.hpp"
 
 #include "ExcelParser.hpp"
+#include "SheetArena.hpp"
+#include "SimdScan.hpp"
+#include "XmlStreamReader.hpp"
 
 using namespace std;
 using namespace excel_parser;
@@ -12,6 +19,33 @@ int test_closeExcelFile();
 int test_getSheet();
 int test_getSharedString();
 int test_getSheetNames();
+int test_streamSheet();
+int test_getColumnarSheet();
+int test_getSheetHandle();
+int test_concurrentAccess();
+int test_parallelOpen();
+int test_getSharedStringTable();
+int test_typedCells();
+int test_lazyOpen();
+int test_memoryOpen();
+int test_projection();
+int test_openExcelFiles();
+int test_openSheetReader();
+int test_workbookCache();
+int test_memoryBudget();
+int test_instrumentation();
+int test_cellReference();
+int test_xmlScan();
+int test_chunkedSheet();
+int test_sheetArena();
+int test_readAhead();
+int test_reloadExcelFile();
+int test_columnIndex();
+int test_resolveStrings();
+int test_columnAggregates();
+int test_arrowExport();
+int test_readSheetAs();
+int test_tryOpenExcelFile();
 
 int main()
 {
@@ -25,6 +59,60 @@ int main()
 	cout << "Test of getSharedString passed " << passed << "/2 tests." << endl;
 	passed = test_getSheetNames();
 	cout << "Test of getSheetNames passed " << passed << "/1 tests." << endl;
+	passed = test_streamSheet();
+	cout << "Test of streamSheet passed " << passed << "/2 tests." << endl;
+	passed = test_getColumnarSheet();
+	cout << "Test of getColumnarSheet passed " << passed << "/2 tests." << endl;
+	passed = test_getSheetHandle();
+	cout << "Test of getSheetHandle passed " << passed << "/2 tests." << endl;
+	passed = test_concurrentAccess();
+	cout << "Test of concurrentAccess passed " << passed << "/1 tests." << endl;
+	passed = test_parallelOpen();
+	cout << "Test of parallelOpen passed " << passed << "/2 tests." << endl;
+	passed = test_getSharedStringTable();
+	cout << "Test of getSharedStringTable passed " << passed << "/2 tests." << endl;
+	passed = test_typedCells();
+	cout << "Test of typedCells passed " << passed << "/4 tests." << endl;
+	passed = test_lazyOpen();
+	cout << "Test of lazyOpen passed " << passed << "/3 tests." << endl;
+	passed = test_memoryOpen();
+	cout << "Test of memoryOpen passed " << passed << "/3 tests." << endl;
+	passed = test_projection();
+	cout << "Test of projection passed " << passed << "/2 tests." << endl;
+	passed = test_openExcelFiles();
+	cout << "Test of openExcelFiles passed " << passed << "/2 tests." << endl;
+	passed = test_openSheetReader();
+	cout << "Test of openSheetReader passed " << passed << "/2 tests." << endl;
+	passed = test_workbookCache();
+	cout << "Test of workbookCache passed " << passed << "/5 tests." << endl;
+	passed = test_memoryBudget();
+	cout << "Test of memoryBudget passed " << passed << "/5 tests." << endl;
+	passed = test_instrumentation();
+	cout << "Test of instrumentation passed " << passed << "/2 tests." << endl;
+	passed = test_cellReference();
+	cout << "Test of cellReference passed " << passed << "/3 tests." << endl;
+	passed = test_xmlScan();
+	cout << "Test of xmlScan passed " << passed << "/3 tests." << endl;
+	passed = test_chunkedSheet();
+	cout << "Test of chunkedSheet passed " << passed << "/3 tests." << endl;
+	passed = test_sheetArena();
+	cout << "Test of sheetArena passed " << passed << "/2 tests." << endl;
+	passed = test_readAhead();
+	cout << "Test of readAhead passed " << passed << "/4 tests." << endl;
+	passed = test_reloadExcelFile();
+	cout << "Test of reloadExcelFile passed " << passed << "/6 tests." << endl;
+	passed = test_columnIndex();
+	cout << "Test of columnIndex passed " << passed << "/3 tests." << endl;
+	passed = test_resolveStrings();
+	cout << "Test of resolveStrings passed " << passed << "/5 tests." << endl;
+	passed = test_columnAggregates();
+	cout << "Test of columnAggregates passed " << passed << "/3 tests." << endl;
+	passed = test_arrowExport();
+	cout << "Test of arrowExport passed " << passed << "/4 tests." << endl;
+	passed = test_readSheetAs();
+	cout << "Test of readSheetAs passed " << passed << "/3 tests." << endl;
+	passed = test_tryOpenExcelFile();
+	cout << "Test of tryOpenExcelFile passed " << passed << "/6 tests." << endl;
 }
 
 int test_openExcelFile()
@@ -105,11 +193,11 @@ int test_getSharedString()
 	{
 		parser->openExcelFile(test_name);
 		sheet sheet = parser->getSheet(test_name, "sheet");
-		if (parser->getSharedString(test_name, stoi(sheet.at(1).at("A").value)).compare("TestColum") == 0)
+		if (parser->getSharedString(test_name, sheet.at(1).at("A").getStringIndex()).compare("TestColum") == 0)
 		{
 			++test_passes;
 		}
-		if (parser->getSharedString(test_name, stoi(sheet.at(2).at("A").value)).compare("row 1") == 0)
+		if (parser->getSharedString(test_name, sheet.at(2).at("A").getStringIndex()).compare("row 1") == 0)
 		{
 			++test_passes;
 		}
@@ -140,3 +228,1483 @@ int test_getSheetNames()
 	}
 	return test_passes;
 }
+int test_streamSheet()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		int rows = 0;
+		int last_row_id = 0;
+		uint32_t first_value = 1;
+		parser->streamSheet(test_name, "sheet", [&](int row_id, const row &r)
+							{
+								if (rows == 0)
+								{
+									first_value = r.at("A").getStringIndex();
+								}
+								++rows;
+								last_row_id = row_id; });
+		if (rows == 3 && last_row_id == 3)
+		{
+			++test_passes;
+		}
+		parser->openExcelFile(test_name);
+		if (first_value == parser->getSheet(test_name, "sheet").at(1).at("A").getStringIndex())
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_getColumnarSheet()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		parser->openExcelFile(test_name);
+		ColumnarSheet columnar = parser->getColumnarSheet(test_name, "sheet");
+		if (columnar.getFirstRow() == 1 && columnar.getRowCount() == 3 && columnar.getColumnCount() == 1)
+		{
+			++test_passes;
+		}
+		const ColumnarSheet::Column &column = columnar.getColumn("A");
+		if (column.isString(1) && !column.isNumber(1) && parser->getSharedString(test_name, column.getStringIndices()[1]).compare("row 1") == 0)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_getSheetHandle()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		parser->openExcelFile(test_name);
+		sheet_handle handle = parser->getSheetHandle(test_name, "sheet");
+		if (handle == parser->getSheetHandle(test_name, "sheet"))
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+		if (handle->size() == 3 && handle->at(1).at("A").type == STRING && handle->at(1).at("A").getStringIndex() == 0)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_concurrentAccess()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	atomic<int> reads(0);
+	vector<thread> threads;
+	for (int i = 0; i < 8; ++i)
+	{
+		threads.emplace_back([&, i]()
+							 {
+								 try
+								 {
+									 for (int j = 0; j < 20; ++j)
+									 {
+										 parser->openExcelFile(test_name);
+										 sheet_handle s = parser->getSheetHandle(test_name, "sheet");
+										 if (parser->getSharedString(test_name, s->at(2).at("A").getStringIndex()).compare("row 1") == 0)
+										 {
+											 ++reads;
+										 }
+										 if (i == 0 && j % 5 == 0)
+										 {
+											 parser->closeExcelFile(test_name);
+										 }
+									 }
+								 }
+								 catch (runtime_error e)
+								 {
+									 // A reader can lose the race with closeExcelFile, which is reported as an error.
+								 } });
+	}
+	for (auto &t : threads)
+	{
+		t.join();
+	}
+	if (reads > 0)
+	{
+		++test_passes;
+	}
+	return test_passes;
+}
+int test_parallelOpen()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		open_options_t options;
+		options.threads = 4;
+		load_report_t report = parser->openExcelFile(test_name, options);
+		if (report.threads == 2 && report.sheet_timings.size() == 2 && report.sheet_timings.at("sheet").rows == 3)
+		{
+			++test_passes;
+		}
+		sheet s = parser->getSheet(test_name, "2sheetOrNot2sheet");
+		if (parser->getSharedString(test_name, s.at(1).at("A").getStringIndex()).compare("Test Colum") == 0)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_getSharedStringTable()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		parser->openExcelFile(test_name);
+		shared_ptr<const SharedStringTable> table = parser->getSharedStringTable(test_name);
+		if (table->size() == 5 && table->at(3) == "Test Colum" && parser->getSharedStringView(test_name, 4) == "row2")
+		{
+			++test_passes;
+		}
+		SharedStringTable interned;
+		interned.append("first");
+		interned.append("second");
+		interned.append("first");
+		interned.finish();
+		if (interned.size() == 3 && interned.at(2) == "first" && interned.getArenaSize() == 11)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_typedCells()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		parser->openExcelFile(test_name);
+		sheet_handle s = parser->getSheetHandle(test_name, "numbers");
+		const cell_t &b3 = s->at(3).at("B");
+		if (s->size() == 9 && b3.type == NUMBER && b3.getNumber() == 4.5 && s->at(3).at("D").getNumber() == 1)
+		{
+			++test_passes;
+		}
+		const cell_t &c4 = s->at(4).at("C");
+		if (c4.type == STRING && parser->getSharedString(test_name, c4.getStringIndex()).compare("beta") == 0)
+		{
+			++test_passes;
+		}
+		// Formula string results keep their text in the cell, and rows without values are still skipped.
+		const cell_t *e7 = s->at(7).find("E");
+		if (e7 != nullptr && e7->type == INLINE_STRING && e7->hasText() && e7->getText() == "x" && s->find(5) == s->end())
+		{
+			++test_passes;
+		}
+
+		// Inline strings join their text runs without the phonetic hints, and errors and dates keep their text.
+		string document = "<row r=\"2\"><c r=\"A2\" t=\"inlineStr\"><is><r><t>in</t></r><r><t>line &amp; more</t></r>"
+						  "<rPh><t>x</t></rPh></is></c><c r=\"B2\" t=\"e\"><f>1/0</f><v>#DIV/0!</v></c>"
+						  "<c r=\"C2\" t=\"d\"><v>2022-07-07T00:00:00</v></c><c r=\"D2\" t=\"str\"><v></v></c></row>";
+		MemorySource source(document.data(), document.size());
+		XmlStreamReader xml_reader(source);
+		SheetReader cursor(xml_reader, projection_t(), true);
+		if (cursor.next() && cursor.getRow().size() == 4)
+		{
+			const row &r = cursor.getRow();
+			if (r.at("A").type == INLINE_STRING && r.at("A").getText() == "inline & more" &&
+				r.at("B").type == ERROR && r.at("B").getText() == "#DIV/0!" &&
+				r.at("C").type == INLINE_STRING && r.at("C").getText() == "2022-07-07T00:00:00" &&
+				r.at("D").hasText() && r.at("D").getText().empty())
+			{
+				++test_passes;
+			}
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_lazyOpen()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		open_options_t options;
+		options.lazy = true;
+		load_report_t report = parser->openExcelFile(test_name, options);
+		if (report.sheet_timings.empty() && parser->getSheetNames(test_name).size() == 2)
+		{
+			++test_passes;
+		}
+		sheet_handle s = parser->getSheetHandle(test_name, "2sheetOrNot2sheet");
+		if (s == parser->getSheetHandle(test_name, "2sheetOrNot2sheet") && s->size() == 3)
+		{
+			++test_passes;
+		}
+		if (parser->getSharedString(test_name, s->at(3).at("A").getStringIndex()).compare("row2") == 0)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_memoryOpen()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		open_options_t options;
+		options.memory_map = true;
+		options.threads = 2;
+		parser->openExcelFile(test_name, options);
+		if (parser->getSharedString(test_name, parser->getSheetHandle(test_name, "sheet")->at(1).at("A").getStringIndex()).compare("TestColum") == 0)
+		{
+			++test_passes;
+		}
+
+		ifstream file(test_name, ios::binary);
+		vector<char> contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+		options.lazy = true;
+		parser->openExcelBuffer("buffered", std::move(contents), options);
+		if (parser->getSharedString("buffered", parser->getSheetHandle("buffered", "2sheetOrNot2sheet")->at(1).at("A").getStringIndex()).compare("Test Colum") == 0)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile("buffered");
+
+		// An empty buffer fails rather than reading the file of the same name.
+		parser->closeExcelFile(test_name);
+		try
+		{
+			parser->openExcelBuffer(test_name, vector<char>(), options);
+		}
+		catch (runtime_error e)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_projection()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		open_options_t options;
+		options.projection.columns = {"A", "C"};
+		options.projection.first_row = 3;
+		options.projection.last_row = 7;
+		parser->openExcelFile(test_name, options);
+		sheet_handle s = parser->getSheetHandle(test_name, "numbers");
+		if (s->size() == 4 && s->begin()->first == 3 && s->rbegin()->first == 7 && s->at(7).size() == 2 && s->at(4).count("B") == 0)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		projection_t projection;
+		projection.last_row = 2;
+		int rows = 0;
+		parser->streamSheet(test_name, "numbers", [&rows](int, const row &r)
+							{ rows += r.size() == 4 ? 1 : 0; }, projection);
+		if (rows == 2)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_openExcelFiles()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	vector<string> file_names = {string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx"),
+								 string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx"),
+								 string(PROJECT_DIRECTORY) + string("/input/MissingBook.xlsx")};
+	try
+	{
+		for (auto &file_name : file_names)
+		{
+			parser->closeExcelFile(file_name);
+		}
+		open_options_t options;
+		options.threads = 3;
+		vector<batch_result_t> results = parser->openExcelFiles(file_names, options);
+		if (results.size() == 3 && results[0].success && results[1].success && !results[2].success && !results[2].error.empty())
+		{
+			++test_passes;
+		}
+		if (parser->getSheetHandle(file_names[1], "numbers")->size() == 9 && parser->getSheetNames(file_names[0]).size() == 2)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(file_names[1]);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_openSheetReader()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		unique_ptr<SheetReader> cursor = parser->openSheetReader(test_name, "numbers");
+		int rows = 0;
+		double total = 0;
+		while (cursor->next())
+		{
+			++rows;
+			total += cursor->getRow().at("A").getNumber();
+		}
+		if (rows == 9 && total == 50 && !cursor->next())
+		{
+			++test_passes;
+		}
+
+		projection_t projection;
+		projection.columns = {"B"};
+		projection.first_row = 6;
+		cursor = parser->openSheetReader(test_name, "numbers", projection);
+		if (cursor->next() && cursor->getRowId() == 6 && cursor->getRow().size() == 1 && cursor->getRow().at("B").getNumber() == 9)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_workbookCache()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	string cache_directory = (filesystem::temp_directory_path() / "ExcelParserCache").string();
+	try
+	{
+		filesystem::remove_all(cache_directory);
+		parser->closeExcelFile(test_name);
+		open_options_t options;
+		options.cache_directory = cache_directory;
+		load_report_t cold = parser->openExcelFile(test_name, options);
+		sheet expected = parser->getSheet(test_name, "numbers");
+		parser->closeExcelFile(test_name);
+
+		load_report_t warm = parser->openExcelFile(test_name, options);
+		if (!cold.from_cache && warm.from_cache)
+		{
+			++test_passes;
+		}
+		sheet s = parser->getSheet(test_name, "numbers");
+		sheet_handle handle = parser->getSheetHandle(test_name, "numbers");
+		if (s.size() == expected.size() && s.at(10).at("B").getNumber() == 15 && parser->getSharedString(test_name, s.at(4).at("C").getStringIndex()).compare("beta") == 0 &&
+			handle->at(7).at("E").type == INLINE_STRING && handle->at(7).at("E").getText() == "x")
+		{
+			++test_passes;
+		}
+
+		// The cache records the signatures of the sheets, so a reload keeps the sheets read from it.
+		load_report_t reloaded = parser->reloadExcelFile(test_name, options);
+		if (reloaded.reused_sheets > 0 && parser->getSheetHandle(test_name, "numbers") == handle)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// A copy that is only touched is hashed and still read from the cache, while one with new contents is not.
+		string copy_name = (filesystem::path(cache_directory) / "NumberBookCopy.xlsx").string();
+		filesystem::copy_file(test_name, copy_name);
+		parser->openExcelFile(copy_name, options);
+		parser->closeExcelFile(copy_name);
+		filesystem::last_write_time(copy_name, filesystem::last_write_time(copy_name) + chrono::hours(1));
+		bool touched = parser->openExcelFile(copy_name, options).from_cache;
+		parser->closeExcelFile(copy_name);
+		{
+			// The modification time of the first local file header is not read back, so the archive stays valid.
+			fstream file(copy_name, ios::in | ios::out | ios::binary);
+			file.seekg(10);
+			char time_byte = static_cast<char>(file.get() ^ 1);
+			file.seekp(10);
+			file.put(time_byte);
+		}
+		filesystem::last_write_time(copy_name, filesystem::last_write_time(copy_name) + chrono::hours(2));
+		open_result_t changed = parser->tryOpenExcelFile(copy_name, options);
+		if (touched && changed.success && !changed.report.from_cache)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(copy_name);
+
+		// Every writer renames its own temporary file, so none are left behind.
+		size_t leftover = 0;
+		for (auto &entry : filesystem::directory_iterator(cache_directory))
+		{
+			leftover += entry.path().extension() == ".tmp";
+		}
+		if (leftover == 0)
+		{
+			++test_passes;
+		}
+		filesystem::remove_all(cache_directory);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_memoryBudget()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		parser->openExcelFile(test_name);
+		sheet_handle before = parser->getSheetHandle(test_name, "sheet");
+		cache_stats_t stats = parser->getCacheStats();
+		if (stats.usage > 0 && stats.hits > 0)
+		{
+			++test_passes;
+		}
+
+		// A budget of one byte evicts every sheet, which is read again when next requested.
+		parser->setMemoryBudget(1);
+		stats = parser->getCacheStats();
+		sheet_handle after = parser->getSheetHandle(test_name, "sheet");
+		if (stats.usage == 0 && stats.evictions >= 2 && after != before && after->size() == before->size())
+		{
+			++test_passes;
+		}
+		parser->getSheetHandle(test_name, "2sheetOrNot2sheet");
+		if (parser->getCacheStats().misses == stats.misses + 2 && parser->getCacheStats().evictions == stats.evictions + 1)
+		{
+			++test_passes;
+		}
+
+		// Columnar sheets and indexes are charged as an entry of their own, which can be evicted without the sheet.
+		parser->setMemoryBudget(0);
+		after = parser->getSheetHandle(test_name, "sheet");
+		size_t sheets_usage = parser->getCacheStats().usage;
+		shared_ptr<const ColumnarSheet> columnar = parser->getColumnarSheetHandle(test_name, "sheet");
+		shared_ptr<const ColumnIndex> index = parser->getColumnIndex(test_name, "sheet", "A");
+		size_t derived_usage = parser->getCacheStats().usage;
+		parser->getSheetHandle(test_name, "2sheetOrNot2sheet");
+		parser->getSheetHandle(test_name, "sheet");
+		parser->setMemoryBudget(sheets_usage);
+		if (derived_usage == sheets_usage + columnar->getMemoryUsage() + index->getMemoryUsage() &&
+			parser->getCacheStats().usage == sheets_usage && parser->getSheetHandle(test_name, "sheet") == after)
+		{
+			parser->setMemoryBudget(0);
+			if (parser->getColumnarSheetHandle(test_name, "sheet") != columnar)
+			{
+				++test_passes;
+			}
+		}
+		parser->setMemoryBudget(0);
+		parser->closeExcelFile(test_name);
+
+		// An evicted sheet is not read again from a file rewritten since it was opened, as its string indices would
+		// name the text of the new shared strings.
+		string copy_name = (filesystem::temp_directory_path() / "ExcelParserBudget.xlsx").string();
+		filesystem::copy_file(test_name, copy_name, filesystem::copy_options::overwrite_existing);
+		parser->openExcelFile(copy_name);
+		parser->setMemoryBudget(1);
+		{
+			int zip_error = 0;
+			zip *original = zip_open(test_name.c_str(), ZIP_RDONLY, &zip_error);
+			zip *book = zip_open(copy_name.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &zip_error);
+			vector<string> parts(zip_get_num_entries(original, 0));
+			for (zip_int64_t i = 0; i < static_cast<zip_int64_t>(parts.size()); ++i)
+			{
+				zip_stat_t stat;
+				zip_stat_index(original, i, 0, &stat);
+				parts[i].resize(stat.size);
+				zip_file *file = zip_fopen_index(original, i, 0);
+				zip_fread(file, &parts[i][0], stat.size);
+				zip_fclose(file);
+				string part_name = zip_get_name(original, i, 0);
+				size_t text = parts[i].find("TestColum");
+				if (part_name == "xl/sharedStrings.xml" && text != string::npos)
+				{
+					parts[i].replace(text, 9, "Rewritten text");
+				}
+				zip_file_add(book, part_name.c_str(), zip_source_buffer(book, parts[i].data(), parts[i].size(), 0), ZIP_FL_OVERWRITE);
+			}
+			zip_close(book);
+			zip_close(original);
+		}
+		try
+		{
+			parser->getSheetHandle(copy_name, "sheet");
+		}
+		catch (runtime_error e)
+		{
+			parser->setMemoryBudget(0);
+			parser->reloadExcelFile(copy_name);
+			if (string(e.what()).find("changed") != string::npos &&
+				parser->getSharedString(copy_name, parser->getSheetHandle(copy_name, "sheet")->at(1).at("A").getStringIndex()).compare("Rewritten text") == 0)
+			{
+				++test_passes;
+			}
+		}
+		parser->setMemoryBudget(0);
+		parser->closeExcelFile(copy_name);
+		filesystem::remove(copy_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_instrumentation()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		load_report_t report = parser->openExcelFile(test_name, open_options_t());
+		sheet_timing_t timing = report.sheet_timings.at("numbers");
+		if (timing.cells == 37 && timing.uncompressed_bytes > 0 && report.shared_strings == 3 &&
+			report.uncompressed_bytes > timing.uncompressed_bytes && report.estimated_bytes > 0)
+		{
+			++test_passes;
+		}
+
+		parser->resetUsageStats();
+		parser->setInstrumentation(true);
+		parser->getSheetHandle(test_name, "numbers");
+		parser->getSharedString(test_name, 0);
+		parser->getSharedString(test_name, 1);
+		parser->setInstrumentation(false);
+		parser->getSheetHandle(test_name, "numbers");
+		usage_stats_t stats = parser->getUsageStats();
+		if (stats.sheet_requests == 1 && stats.shared_string_requests == 2 && stats.lock_acquisitions >= 3)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_cellReference()
+{
+	static_assert(columnIndex("xfd") == max_column_index && columnIndex("XFE") == -1, "Column letters must be decoded at compile time.");
+
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		int row_id = 0;
+		int column_index = 0;
+		if (columnIndex("A") == 0 && columnIndex("z") == 25 && columnIndex("AA") == 26 && columnIndex("XFD") == 16383 &&
+			columnIndex("XFE") == -1 && columnIndex("AAAAAAAAAAAA") == -1 && columnIndex("A1B") == -1 && columnIndex("") == -1 &&
+			columnName(16383).compare("XFD") == 0 && cellReference(3, 1).compare("B3") == 0)
+		{
+			++test_passes;
+		}
+		if (parseCellReference("ab12", row_id, column_index) && row_id == 12 && column_index == 27 &&
+			!parseCellReference("12", row_id, column_index) && !parseCellReference("B", row_id, column_index) &&
+			!parseCellReference("B3C", row_id, column_index) && !parseCellReference("XFE1", row_id, column_index) &&
+			!parseCellReference("A99999999999", row_id, column_index) && !parseCellReference("A0", row_id, column_index) &&
+			!parseCellReference("A00", row_id, column_index) && parseCellReference("XFD1048576", row_id, column_index))
+		{
+			++test_passes;
+		}
+
+		parser->openExcelFile(test_name);
+		sheet_handle s = parser->getSheetHandle(test_name, "numbers");
+		const row &r = s->at(3);
+		int previous = -1;
+		bool ordered = true;
+		for (auto &column_cell : r)
+		{
+			ordered = ordered && column_cell.first > previous;
+			previous = column_cell.first;
+		}
+		if (ordered && r.size() == 4 && &r.at(1) == &r.at("B") && r.count(1) == 1 && r.count(4) == 0)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_xmlScan()
+{
+	int test_passes = 0;
+	try
+	{
+		// Place the delimiter at every offset so each vector width and the scalar tail are exercised.
+		bool found_all = true;
+		for (size_t offset = 0; offset < 100; ++offset)
+		{
+			string block(100, 'x');
+			block[offset] = '"';
+			found_all = found_all && simd::findAny(block.data(), block.size(), '>', '"', '\'') == offset;
+		}
+		if (found_all && simd::findAny("xxxx", 4, '>', '"', '\'') == 4)
+		{
+			++test_passes;
+		}
+
+		uint64_t value = 0;
+		if (simd::parseDigits("1234567890123", "1234567890123" + 13, value) && value == 1234567890123ULL &&
+			!simd::parseDigits("12345678.5", "12345678.5" + 10, value) && !simd::parseDigits("1234567/", "1234567/" + 8, value))
+		{
+			++test_passes;
+		}
+
+		// Read a document a few bytes at a time so tags and quoted values are split across fills.
+		string document = "<row r=\"1\"><c r=\"A1\" f='a>b' t=\"s\"><v>12345678901</v></c><c r=\"B1\"/></row>";
+		MemorySource source(document.data(), document.size());
+		XmlStreamReader reader(source, 3);
+		string_view attribute;
+		int cells = 0;
+		bool values_read = false;
+		for (XmlEvent event = reader.next(); event != END_DOCUMENT; event = reader.next())
+		{
+			if (event == START_ELEMENT && reader.name() == "c")
+			{
+				++cells;
+				if (cells == 1 && reader.attribute("f", attribute) && attribute == "a>b" && reader.attribute("t", attribute) && attribute == "s")
+				{
+					values_read = true;
+				}
+			}
+			else if (event == TEXT && reader.text() != "12345678901")
+			{
+				values_read = false;
+			}
+		}
+		if (cells == 2 && values_read)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_chunkedSheet()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		parser->openExcelFile(test_name);
+		sheet whole = parser->getSheet(test_name, "numbers");
+		parser->closeExcelFile(test_name);
+
+		// Split every sheet, however small, into as many chunks as it has rows.
+		open_options_t options;
+		options.threads = 4;
+		options.chunk_bytes = 1;
+		load_report_t report = parser->openExcelFile(test_name, options);
+		sheet_timing_t timing = report.sheet_timings.at("numbers");
+		if (report.threads == 4 && timing.rows == whole.size() && timing.cells == 37)
+		{
+			++test_passes;
+		}
+		sheet chunked = parser->getSheet(test_name, "numbers");
+		bool same = chunked.size() == whole.size();
+		for (auto it = whole.begin(), other = chunked.begin(); same && it != whole.end(); ++it, ++other)
+		{
+			same = it->first == other->first && it->second.size() == other->second.size();
+			for (auto &column_cell : it->second)
+			{
+				const cell_t *c = other->second.find(column_cell.first);
+				same = same && c != nullptr && c->type == column_cell.second.type &&
+					   (c->type == NUMBER ? c->getNumber() == column_cell.second.getNumber() : c->getStringIndex() == column_cell.second.getStringIndex());
+			}
+		}
+		if (same)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		options.projection.first_row = 3;
+		options.projection.last_row = 6;
+		parser->openExcelFile(test_name, options);
+		sheet_handle projected = parser->getSheetHandle(test_name, "numbers");
+		if (projected->size() == 3 && projected->begin()->first == 3 && projected->rbegin()->first == 6)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_sheetArena()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		SheetArena arena;
+		SheetArena &child = arena.createChild();
+		SheetArena other;
+		sheet &s = arena.getSheet();
+		sheet partial(&child);
+		partial.try_emplace(1).first->second.set(0, cell_t::makeNumber(2));
+		s.insert(s.end(), partial.extract(partial.begin()));
+		if (arena.is_equal(child) && !arena.is_equal(other) && s.at(1).at("A").getNumber() == 2 && arena.getAllocatedBytes() > sizeof(sheet))
+		{
+			++test_passes;
+		}
+
+		// Handles keep the arena of their sheet alive after the file is closed, and copies leave the arena behind.
+		parser->openExcelFile(test_name);
+		sheet_handle handle = parser->getSheetHandle(test_name, "numbers");
+		sheet copy = parser->getSheet(test_name, "numbers");
+		parser->closeExcelFile(test_name);
+		if (dynamic_cast<SheetArena *>(handle->get_allocator().resource()) != nullptr &&
+			copy.get_allocator().resource() == std::pmr::get_default_resource() &&
+			handle->size() == copy.size() && handle->at(3).at("B").getNumber() == 4.5)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_readAhead()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		// Blocks far smaller than the reads make the consumer wait on the producer and wrap around the ring.
+		string data;
+		for (int i = 0; i < 5000; ++i)
+		{
+			data += to_string(i) + ",";
+		}
+		MemorySource memory(data.data(), data.size());
+		string copy;
+		{
+			PrefetchSource prefetch(memory, 3, 7);
+			char buffer[100];
+			for (size_t bytes_read = prefetch.read(buffer, sizeof(buffer)); bytes_read > 0; bytes_read = prefetch.read(buffer, sizeof(buffer)))
+			{
+				copy.append(buffer, bytes_read);
+			}
+		}
+		if (copy == data)
+		{
+			++test_passes;
+		}
+
+		// Destroying the source before it is drained must stop the producer.
+		{
+			MemorySource unread(data.data(), data.size());
+			PrefetchSource prefetch(unread, 2, 16);
+			char buffer[4];
+			prefetch.read(buffer, sizeof(buffer));
+		}
+		++test_passes;
+
+		parser->closeExcelFile(test_name);
+		open_options_t options;
+		options.read_ahead = true;
+		load_report_t report = parser->openExcelFile(test_name, options);
+		sheet_handle s = parser->getSheetHandle(test_name, "numbers");
+		if (report.sheet_timings.at("numbers").cells == 37 && s->size() == 9 && s->at(3).at("B").getNumber() == 4.5)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// Sheets of lazily opened files are read ahead when they are first requested.
+		options.lazy = true;
+		parser->openExcelFile(test_name, options);
+		s = parser->getSheetHandle(test_name, "numbers");
+		if (s->size() == 9 && s->at(3).at("B").getNumber() == 4.5 && s->at(7).at("E").getText() == "x")
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_reloadExcelFile()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = (filesystem::temp_directory_path() / "ExcelParserReload.xlsx").string();
+	try
+	{
+		filesystem::copy_file(string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx"), test_name, filesystem::copy_options::overwrite_existing);
+		parser->closeExcelFile(test_name);
+		parser->openExcelFile(test_name);
+		sheet_handle original = parser->getSheetHandle(test_name, "numbers");
+
+		// An unchanged file keeps every sheet without parsing any of them.
+		load_report_t unchanged = parser->reloadExcelFile(test_name);
+		if (unchanged.reused_sheets == 1 && unchanged.sheet_timings.empty() && parser->getSheetHandle(test_name, "numbers") == original)
+		{
+			++test_passes;
+		}
+
+		// A replaced file publishes its new sheets and shared strings together.
+		filesystem::copy_file(string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx"), test_name, filesystem::copy_options::overwrite_existing);
+		load_report_t changed = parser->reloadExcelFile(test_name);
+		sheet s = parser->getSheet(test_name, "sheet");
+		if (changed.reused_sheets == 0 && parser->getSheetNames(test_name).size() == 2 &&
+			parser->getSharedString(test_name, s.at(1).at("A").getStringIndex()).compare("TestColum") == 0)
+		{
+			++test_passes;
+		}
+
+		// Handles to the previous version stay valid after it has been replaced.
+		if (original->size() == 9 && original->at(3).at("B").getNumber() == 4.5)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// A lazily opened file that never read its shared strings has them once it is reloaded eagerly.
+		open_options_t lazy_options;
+		lazy_options.lazy = true;
+		parser->openExcelFile(test_name, lazy_options);
+		parser->reloadExcelFile(test_name, open_options_t());
+		if (parser->getSharedStringTable(test_name)->size() > 0 &&
+			parser->getSharedString(test_name, parser->getSheet(test_name, "sheet").at(1).at("A").getStringIndex()).compare("TestColum") == 0)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// Without new options a file is reloaded with those it was opened with, so its sheets keep their projection.
+		open_options_t projected_options;
+		projected_options.projection.columns = {"A"};
+		parser->openExcelFile(test_name, projected_options);
+		filesystem::copy_file(string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx"), test_name, filesystem::copy_options::overwrite_existing);
+		parser->reloadExcelFile(test_name);
+		sheet_handle projected = parser->getSheetHandle(test_name, "numbers");
+		bool only_a = !projected->empty();
+		for (auto &row_cells : *projected)
+		{
+			only_a = only_a && row_cells.second.size() == 1 && row_cells.second.count("A") == 1;
+		}
+		if (only_a)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// A file opened from a buffer has nothing on disk to be reloaded from.
+		ifstream file(test_name, ios::binary);
+		vector<char> contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+		parser->openExcelBuffer("reload buffer", std::move(contents));
+		open_result_t buffer_reload = parser->tryReloadExcelFile("reload buffer");
+		if (!buffer_reload.success && buffer_reload.error.find("buffer") != string::npos && parser->getSheetNames("reload buffer").size() == 1)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile("reload buffer");
+		filesystem::remove(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_columnIndex()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		parser->openExcelFile(test_name);
+		shared_ptr<const ColumnIndex> strings = parser->getColumnIndex(test_name, "numbers", "C");
+		if (strings->findEqual("beta") == vector<int>{1, 4, 7, 10} && strings->findEqual("delta").empty() && parser->getColumnIndex(test_name, "numbers", "C") == strings)
+		{
+			++test_passes;
+		}
+
+		shared_ptr<const ColumnIndex> numbers = parser->getColumnIndex(test_name, "numbers", "B", SORTED_INDEX);
+		if (numbers->findRange(4, 10) == vector<int>{3, 4, 6} && numbers->findEqual(9.0) == vector<int>{6} && numbers->size() == 9)
+		{
+			++test_passes;
+		}
+
+		// Hash indexes only answer equality lookups.
+		try
+		{
+			parser->getColumnIndex(test_name, "numbers", "B")->findRange(4, 10);
+		}
+		catch (runtime_error e)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_resolveStrings()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		parser->openExcelFile(test_name);
+		const cell_t &unresolved = parser->getSheetHandle(test_name, "numbers")->at(4).at("C");
+		if (!unresolved.hasText() && sizeof(cell_t) == 16)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// Resolved text stays valid after the file is closed, as the sheet keeps the shared strings alive.
+		open_options_t options;
+		options.resolve_strings = true;
+		parser->openExcelFile(test_name, options);
+		sheet_handle s = parser->getSheetHandle(test_name, "numbers");
+		parser->closeExcelFile(test_name);
+		if (s->at(4).at("C").hasText() && s->at(4).at("C").getText() == "beta" && s->at(8).at("C").getText() == "gamma" && !s->at(4).at("B").hasText())
+		{
+			++test_passes;
+		}
+
+		options.lazy = true;
+		parser->openExcelFile(test_name, options);
+		const cell_t &lazy = parser->getSheetHandle(test_name, "numbers")->at(3).at("C");
+		if (lazy.hasText() && lazy.getText() == "alpha")
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// Copies point at the text held by the loaded sheet, so they can be read while a handle to it is held.
+		options.lazy = false;
+		parser->openExcelFile(test_name, options);
+		s = parser->getSheetHandle(test_name, "numbers");
+		sheet copy = parser->getSheet(test_name, "numbers");
+		parser->closeExcelFile(test_name);
+		if (copy.at(4).at("C").getText() == "beta" && copy.at(7).at("E").getText() == "x")
+		{
+			++test_passes;
+		}
+		s = nullptr;
+
+		// Reloading with resolve_strings resolves the sheets of a file opened without it.
+		parser->openExcelFile(test_name);
+		parser->reloadExcelFile(test_name, options);
+		const cell_t &reloaded = parser->getSheetHandle(test_name, "numbers")->at(4).at("C");
+		if (reloaded.hasText() && reloaded.getText() == "beta")
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_columnAggregates()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		parser->closeExcelFile(test_name);
+		parser->openExcelFile(test_name);
+		aggregate_t all = parser->aggregateColumn(test_name, "numbers", "B");
+		aggregate_t range = parser->aggregateColumn(test_name, "numbers", "B", 4, 10);
+		if (all.count == 9 && all.sum == 75 && all.min == 1.5 && all.max == 15 && all.mean() == 75.0 / 9 &&
+			range.count == 3 && range.sum == 19.5 && range.min == 4.5 && range.max == 9)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+
+		// Enough rows for several parallel blocks, with gaps and strings so dense and sparse words are both taken.
+		ColumnarSheet columnar;
+		aggregate_t expected;
+		size_t expected_in_range = 0;
+		for (int row_id = 1; row_id <= 300000; ++row_id)
+		{
+			if (row_id % 1000 == 7)
+			{
+				continue;
+			}
+			row r;
+			if (row_id % 5000 == 11)
+			{
+				r.set(0, cell_t::makeString(0));
+			}
+			else
+			{
+				double value = static_cast<double>(row_id % 977) - 300;
+				r.set(0, cell_t::makeNumber(value));
+				++expected.count;
+				expected.sum += value;
+				expected.min = min(expected.min, value);
+				expected.max = max(expected.max, value);
+				expected_in_range += value >= 0 && value <= 100;
+			}
+			columnar.appendRow(row_id, r);
+		}
+		const ColumnarSheet::Column &column = columnar.getColumn("A");
+		aggregate_t serial = column.aggregate();
+		aggregate_t parallel = column.aggregate(4);
+		if (serial.count == expected.count && serial.sum == expected.sum && serial.min == expected.min && serial.max == expected.max &&
+			parallel.count == expected.count && parallel.sum == expected.sum && parallel.min == expected.min && parallel.max == expected.max)
+		{
+			++test_passes;
+		}
+
+		vector<uint64_t> selection = column.filter(0, 100, 4);
+		vector<int> rows = columnar.getRows(selection);
+		aggregate_t filtered = column.aggregate(selection, 4);
+		if (rows.size() == expected_in_range && filtered.count == expected_in_range && filtered.min == 0 && filtered.max == 100 &&
+			columnar.getRows(column.filter(-299, -299)).front() == 1)
+		{
+			++test_passes;
+		}
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_arrowExport()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	auto dictionaryString = [](const ArrowArray *dictionary, int32_t index)
+	{
+		const int32_t *offsets = static_cast<const int32_t *>(dictionary->buffers[1]);
+		const char *data = static_cast<const char *>(dictionary->buffers[2]);
+		return string(data + offsets[index], offsets[index + 1] - offsets[index]);
+	};
+	auto isValid = [](const ArrowArray *array, size_t offset)
+	{
+		return (static_cast<const uint8_t *>(array->buffers[0])[offset >> 3] >> (offset & 7)) & 1;
+	};
+	try
+	{
+		parser->closeExcelFile(test_name);
+		parser->openExcelFile(test_name);
+		shared_ptr<const ColumnarSheet> columnar = parser->getColumnarSheetHandle(test_name, "numbers");
+		ArrowArray array;
+		ArrowSchema schema;
+		parser->exportSheetToArrow(test_name, "numbers", &array, &schema);
+		// The export keeps the sheet and strings alive after the file has been closed.
+		parser->closeExcelFile(test_name);
+		if (string(schema.format) == "+s" && string(schema.name) == "numbers" && array.length == static_cast<int64_t>(columnar->getRowCount()) &&
+			array.n_children == static_cast<int64_t>(columnar->getColumnCount()) && schema.n_children == array.n_children)
+		{
+			const ArrowArray *numbers = array.children[1];
+			const ColumnarSheet::Column &column = columnar->getColumn("B");
+			bool matches = string(schema.children[1]->format) == "g" && string(schema.children[1]->name) == "B" && numbers->null_count == array.length - 9;
+			for (int64_t i = 0; matches && i < array.length; ++i)
+			{
+				matches = isValid(numbers, i) == column.isNumber(i) &&
+						  (!column.isNumber(i) || static_cast<const double *>(numbers->buffers[1])[i] == column.getNumbers()[i]);
+			}
+			if (matches && static_cast<const double *>(numbers->buffers[1]) == column.getNumbers())
+			{
+				++test_passes;
+			}
+
+			const ArrowArray *strings = array.children[2];
+			const ArrowSchema *strings_schema = schema.children[2];
+			set<string> texts;
+			for (int64_t i = 0; i < strings->length; ++i)
+			{
+				if (isValid(strings, i))
+				{
+					texts.insert(dictionaryString(strings->dictionary, static_cast<const int32_t *>(strings->buffers[1])[i]));
+				}
+			}
+			if (string(strings_schema->format) == "i" && strings_schema->dictionary != nullptr && string(strings_schema->dictionary->format) == "u" &&
+				texts == set<string>({"alpha", "beta", "gamma"}))
+			{
+				++test_passes;
+			}
+		}
+		array.release(&array);
+		schema.release(&schema);
+
+		// A column holding numbers and strings becomes a union, and interned strings are copied out in order.
+		shared_ptr<SharedStringTable> shared_strings = make_shared<SharedStringTable>();
+		shared_strings->append("a");
+		shared_strings->append("b");
+		shared_strings->append("a");
+		shared_strings->finish();
+		shared_ptr<ColumnarSheet> mixed = make_shared<ColumnarSheet>();
+		row first;
+		first.set(0, cell_t::makeNumber(1.5));
+		mixed->appendRow(1, first);
+		row second;
+		second.set(0, cell_t::makeString(2));
+		mixed->appendRow(2, second);
+		row third;
+		third.set(1, cell_t::makeNumber(3));
+		mixed->appendRow(3, third);
+		ArrowExporter::exportSheet(mixed, shared_strings, "mixed", &array, &schema);
+		mixed.reset();
+		shared_strings.reset();
+		const ArrowArray *column = array.children[0];
+		const int8_t *type_ids = static_cast<const int8_t *>(column->buffers[0]);
+		if (string(schema.children[0]->format) == "+us:0,1" && column->length == 3 && type_ids[0] == 0 && type_ids[1] == 1 && type_ids[2] == 0 &&
+			static_cast<const double *>(column->children[0]->buffers[1])[0] == 1.5 && column->children[0]->null_count == 2 &&
+			dictionaryString(column->children[1]->dictionary, static_cast<const int32_t *>(column->children[1]->buffers[1])[1]) == "a" &&
+			column->children[1]->dictionary->length == 3 && string(schema.children[1]->format) == "g" && array.children[1]->null_count == 2)
+		{
+			++test_passes;
+		}
+		array.release(&array);
+		schema.release(&schema);
+		if (array.release != nullptr || schema.release != nullptr)
+		{
+			--test_passes;
+		}
+
+		// A single cell far to the right leaves the columns before it without any storage, which export as nulls.
+		sheet wide;
+		for (int row_id = 1; row_id <= 100000; ++row_id)
+		{
+			wide[row_id].set(0, cell_t::makeNumber(row_id));
+		}
+		wide[5].set(columnIndex("XFD"), cell_t::makeNumber(-1));
+		shared_ptr<ColumnarSheet> wide_columnar = make_shared<ColumnarSheet>(ColumnarSheet::fromSheet(wide));
+		size_t slots = 0;
+		for (size_t i = 0; i < wide_columnar->getColumnCount(); ++i)
+		{
+			slots += wide_columnar->getColumn(i).size();
+		}
+		ArrowExporter::exportSheet(wide_columnar, nullptr, "wide", &array, &schema);
+		const ArrowArray *gap = array.children[1];
+		const ArrowArray *far = array.children[columnIndex("XFD")];
+		if (slots == 200000 && wide_columnar->getColumnCount() == 16384 && string(schema.children[1]->format) == "n" &&
+			gap->n_buffers == 0 && gap->null_count == 100000 && string(schema.children[columnIndex("XFD")]->format) == "g" &&
+			far->null_count == 99999 && static_cast<const double *>(far->buffers[1])[4] == -1)
+		{
+			++test_passes;
+		}
+		array.release(&array);
+		schema.release(&schema);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_readSheetAs()
+{
+	struct number_row_t
+	{
+		optional<double> a;
+		double b = -1;
+		string c;
+		optional<string> d;
+		int e = -1;
+	};
+	using number_schema = schema_t<number_row_t,
+								   field_t<columnOf("A"), &number_row_t::a>,
+								   field_t<columnOf("B"), &number_row_t::b>,
+								   field_t<columnOf("C"), &number_row_t::c>,
+								   field_t<columnOf("D"), &number_row_t::d>,
+								   field_t<columnOf("E"), &number_row_t::e>>;
+	static_assert(columnOf("A") == 0 && columnOf("AB") == 27 && columnOf("b") == -1, "columnOf must match Excel column letters.");
+	static_assert(number_schema::reads_text, "A schema with string members reads the shared strings.");
+
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/NumberBook.xlsx");
+	try
+	{
+		// The file does not need to be open.
+		parser->closeExcelFile(test_name);
+		vector<number_row_t> records = ExcelParser::readSheetAs<number_schema>(test_name, "numbers");
+
+		parser->openExcelFile(test_name);
+		sheet_handle s = parser->getSheetHandle(test_name, "numbers");
+		bool matches = records.size() == s->size();
+		size_t i = 0;
+		for (auto it = s->begin(); matches && it != s->end(); ++it, ++i)
+		{
+			const row &r = it->second;
+			const cell_t *a = r.find("A");
+			const cell_t *b = r.find("B");
+			const cell_t *c = r.find("C");
+			const cell_t *d = r.find("D");
+			const cell_t *e = r.find("E");
+			matches = (a != nullptr && a->type == NUMBER ? records[i].a == a->getNumber() : !records[i].a.has_value()) &&
+					  (b != nullptr && b->type == NUMBER ? records[i].b == b->getNumber() : records[i].b == -1) &&
+					  (c != nullptr && c->type == STRING ? records[i].c == parser->getSharedString(test_name, c->getStringIndex()) : records[i].c.empty()) &&
+					  (d != nullptr && d->type == STRING ? records[i].d == parser->getSharedString(test_name, d->getStringIndex()) : !records[i].d.has_value()) &&
+					  (e != nullptr && e->type == NUMBER ? records[i].e == static_cast<int>(e->getNumber()) : records[i].e == -1);
+		}
+		if (matches && !records.empty())
+		{
+			++test_passes;
+		}
+
+		// Rows outside the range are skipped, as with a projection.
+		int first_row = s->begin()->first + 1;
+		vector<number_row_t> tail = ExcelParser::readSheetAs<number_schema>(test_name, "numbers", first_row, first_row + 2);
+		if (tail.size() == 3 && tail.front().b == records[1].b && tail.back().c == records[3].c)
+		{
+			++test_passes;
+		}
+
+		// Schemas holding only numbers never need the shared strings.
+		struct price_t
+		{
+			float b = 0;
+			bool positive_b = false;
+		};
+		using price_schema = schema_t<price_t, field_t<columnOf("B"), &price_t::b>, field_t<columnOf("B"), &price_t::positive_b>>;
+		static_assert(!price_schema::reads_text, "A schema with only numeric members skips the shared strings.");
+		vector<price_t> prices = ExcelParser::readSheetAs<price_schema>(test_name, "numbers");
+		double sum = 0;
+		for (const price_t &price : prices)
+		{
+			sum += price.b;
+			matches = matches && price.positive_b == (price.b != 0);
+		}
+		if (matches && prices.size() == records.size() && sum == parser->aggregateColumn(test_name, "numbers", "B").sum)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}
+int test_tryOpenExcelFile()
+{
+	int test_passes = 0;
+	ExcelParser *parser = ExcelParser::getInstance();
+	string garbage_name = (filesystem::temp_directory_path() / "ExcelParserGarbage.xlsx").string();
+	string broken_name = (filesystem::temp_directory_path() / "ExcelParserBrokenSheet.xlsx").string();
+	string test_name = string(PROJECT_DIRECTORY) + string("/input/TestBook.xlsx");
+	try
+	{
+		ExcelParser::resetUsageStats();
+		{
+			ofstream garbage(garbage_name, ios::binary);
+			garbage << "this is not a zip archive";
+		}
+		open_result_t file_result = parser->tryOpenExcelFile(garbage_name);
+		open_result_t buffer_result = parser->tryOpenExcelBuffer("garbage", vector<char>(100, 'x'));
+		if (!file_result.success && !file_result.error.empty() && file_result.file_name == garbage_name &&
+			!buffer_result.success && !buffer_result.error.empty() && ExcelParser::getUsageStats().failed_opens == 2)
+		{
+			++test_passes;
+		}
+
+		// Copies the test book with one part replaced by malformed XML.
+		auto writeBroken = [&test_name, &broken_name](const string &broken_part)
+		{
+			int zip_error = 0;
+			zip *original = zip_open(test_name.c_str(), ZIP_RDONLY, &zip_error);
+			zip *book = zip_open(broken_name.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &zip_error);
+			vector<string> parts(zip_get_num_entries(original, 0));
+			for (zip_int64_t i = 0; i < static_cast<zip_int64_t>(parts.size()); ++i)
+			{
+				string part_name = zip_get_name(original, i, 0);
+				if (part_name == broken_part)
+				{
+					parts[i] = "<worksheet><sheetData><row r=\"1\"><c r=\"A1\"";
+				}
+				else
+				{
+					zip_stat_t stat;
+					zip_stat_index(original, i, 0, &stat);
+					parts[i].resize(stat.size);
+					zip_file *file = zip_fopen_index(original, i, 0);
+					zip_fread(file, &parts[i][0], stat.size);
+					zip_fclose(file);
+				}
+				zip_file_add(book, part_name.c_str(), zip_source_buffer(book, parts[i].data(), parts[i].size(), 0), ZIP_FL_OVERWRITE);
+			}
+			zip_close(book);
+			zip_close(original);
+		};
+
+		// A sheet that cannot be parsed is left out, and the rest of the file is still opened.
+		writeBroken("xl/worksheets/sheet1.xml");
+		open_result_t broken_result = parser->tryOpenExcelFile(broken_name);
+		vector<string> names = broken_result.success ? parser->getSheetNames(broken_name) : vector<string>();
+		if (broken_result.success && broken_result.report.sheet_errors.size() == 1 && broken_result.report.sheet_errors.count("sheet") == 1 &&
+			names == vector<string>({"2sheetOrNot2sheet"}) && ExcelParser::getUsageStats().failed_sheets == 1)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(broken_name);
+
+		// A file missing a sheet is not cached, so the sheet is read again rather than lost on the next open.
+		open_options_t cached;
+		cached.cache_directory = (filesystem::temp_directory_path() / "ExcelParserBrokenCache").string();
+		filesystem::remove_all(cached.cache_directory);
+		parser->tryOpenExcelFile(broken_name, cached);
+		parser->closeExcelFile(broken_name);
+		open_result_t cached_result = parser->tryOpenExcelFile(broken_name, cached);
+		if (cached_result.success && !cached_result.report.from_cache && cached_result.report.sheet_errors.count("sheet") == 1)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(broken_name);
+		filesystem::remove_all(cached.cache_directory);
+
+		// Malformed shared strings fail the whole file rather than leaving cells pointing past a truncated table.
+		writeBroken("xl/sharedStrings.xml");
+		open_result_t strings_result = parser->tryOpenExcelFile(broken_name);
+		if (!strings_result.success && strings_result.error.find("shared strings") != string::npos && ExcelParser::getUsageStats().failed_opens == 3)
+		{
+			++test_passes;
+		}
+
+		// A reload that fails keeps the previous version of the file.
+		filesystem::copy_file(test_name, broken_name, filesystem::copy_options::overwrite_existing);
+		parser->openExcelFile(broken_name);
+		{
+			ofstream garbage(broken_name, ios::binary | ios::trunc);
+			garbage << "this is not a zip archive";
+		}
+		open_result_t reload_result = parser->tryReloadExcelFile(broken_name);
+		if (!reload_result.success && !reload_result.error.empty() && parser->getSheetNames(broken_name).size() == 2 &&
+			ExcelParser::getUsageStats().failed_reloads == 1 && ExcelParser::getUsageStats().failed_opens == 3)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(broken_name);
+
+		// Failures do not disturb other files, and a successful open reports no errors.
+		parser->closeExcelFile(test_name);
+		open_result_t good_result = parser->tryOpenExcelFile(test_name);
+		if (good_result.success && good_result.error.empty() && good_result.report.sheet_errors.empty() &&
+			parser->getSheetNames(test_name).size() == 2 && ExcelParser::getUsageStats().failed_opens == 3)
+		{
+			++test_passes;
+		}
+		parser->closeExcelFile(test_name);
+		filesystem::remove(garbage_name);
+		filesystem::remove(broken_name);
+	}
+	catch (runtime_error e)
+	{
+		cout << e.what() << endl;
+	}
+	return test_passes;
+}